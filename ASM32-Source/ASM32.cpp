@@ -10,102 +10,115 @@
 /// \brief Main translation unit for the ASM32 two-pass assembler.
 /// \details
 /// This file wires together the lexer, parser, AST, code generator,
-/// source listing, and ELF writer. It owns global state used across
-/// passes and drives the full compile → assemble flow.
+/// source listing, and ELF writer. It owns the (thread-local) state used
+/// across passes and drives the full compile → assemble flow, one thread
+/// per assembled file.
 
 #include "constants.hpp"
 #include "ASM32.hpp"
-#include <elfio/elfio_dump.hpp>
+#include <exception>
+#include <thread>
 
 // --------------------------------------------------------------------------------
 //      Global variables
+//
+//  The assembler state belongs to one assembly. Every assembly runs on a
+//  thread of its own (see assembleFile()), so the state is thread-local and
+//  several files can be assembled concurrently. The debug switches and the
+//  stream mode are process-wide options.
 // --------------------------------------------------------------------------------
 
-int         lineNr = 0;                     ///< Current source file line number (1-based).
-int         column;                         ///< Column of the current token within the source line (0-based).
-char        sl[MAX_LINE_LENGTH];            ///< Raw input buffer holding the current source line.
-int         prgType;                        ///< Program type: 0 = undefined, 1 = standalone, 2 = module.
-char        token[MAX_WORD_LENGTH];         ///< Current token text.
-char        tokenSave[MAX_WORD_LENGTH];     ///< Previously seen token text (look-behind).
-char        dataSegmentBase[8];             ///< Registername of actual data segment;
-char        baseRegData[5]; 
-char        currentSegment[50];             ///< actual code segment name
-int         tokTyp;                         ///< Current token type (see TokenType).
-int         tokTypSave;                     ///< Previous token type (look-behind).
-int         numToken;                       ///< Integer value parsed from a numeric token.
-int64_t     value;                          ///< Evaluated numeric value from an expression.
-int         align_val;                      ///< Alignment value for directives that require alignment.
-int         mode;                           ///< Mode for arithmetic or addressing operations.
-bool        lineERR;                        ///< Flag: true if the current line is in error.
-bool        sourceERR = FALSE;                      ///< Flag: true if the source has an error.
-char        label[MAX_WORD_LENGTH];         ///< Most recent label text.
-char        labelCodeOld[MAX_WORD_LENGTH];
-char        labelDataOld[MAX_WORD_LENGTH];
-char        currentCODE[MAX_WORD_LENGTH];
-int         ind = 0;                        ///< Scanner index into the source line during tokenization.
-char        opCode[MAX_WORD_LENGTH];        ///< Opcode mnemonic.
-int         opInstrType;                    ///< Opcode type (maps to opCodeTab[].instrType).
-int         operandType;                    ///< Operand classification used for AST construction.
-int         operandTyp[MAX_WORD_LENGTH];                 ///< Operand types used by code generation.
-int         directiveType;                  ///< Current directive kind (see Directives).
-char        dirCode[MAX_WORD_LENGTH];       ///< Directive mnemonic (as text).
-int         varType;                        ///< Variable classification: 0 = none, 1 = global, 2 = local.
-char        varName[MAX_WORD_LENGTH];       ///< Name of a global/local variable.
-char        buffer[MAX_LINE_LENGTH];                    ///< General-purpose text buffer.
-int64_t     symcodeAdr;                     ///< Code address associated with a symbol table entry.
-int         bin_status;                     ///< Binary status for instructions stored in SRC nodes.
-int         numOfInstructions=0;              ///< counter # of instruction bytes in segment
-int         numOfData;                      ///< counter # of data bytes in segment
-bool        addInstrGlob;                       ///< Flag is TRUE if during assembly additional instrtuctions generated globally
-bool        addInstrLine;                   ///< Flag is true if during assembly additional instrtuctions generated for actual source line
-bool        codeInstrFlag = FALSE;          ///< Flag if .CODE or instruction was read in AST
-int         nodeTypeOld;                     ///< old node type 
-bool        codeExist = FALSE;              ///< flag if a .CODE directive is present before first instruction    
-bool        dataExist = FALSE;              ///< flag if a .DATA directive is present before first definitin of byte,half,word etc.    
-int         numSegment = 0;                 ///< counter of segments for segment table
-
-char        errmsg[MAX_ERROR_LENGTH];       ///< Last error message text.
-char        infmsg[MAX_ERROR_LENGTH];       ///< Informational message (e.g., emitted by codegen).
-bool        is_label;                       ///< Parser helper: current statement starts with a label.
-bool        is_instruction;                 ///< Parser helper: current statement is an instruction.
-bool        is_directive;                   ///< Parser helper: current statement is a directive.
-bool        is_negative;                    ///< Parser helper: next numeric literal is negated.
-int AST_numInstr;                           ///< contains current AST node numInstr.
-int         binInstr;                       ///< Current 32-bit binary instruction being emitted.
-int         binInstrSave;                   ///< Saved binary instruction (e.g., for large offset fixups).
-uint32_t         codeAdr;                        ///< Code address (text section address counter).
-uint32_t         dataAdr;                        ///< Data address (data section address counter).
-
-uint32_t    elfCodeAddr;                    ///< ELF: base virtual address of the text section.
-uint32_t    elfCodeAddrOld;
-uint32_t    elfDataAddr;                    ///< ELF: base virtual address of the data section.
-uint32_t    elfDataAddrOld;
-uint32_t    elfEntryPoint;                  ///< ELF: program entry point address.
-uint32_t    elfCodeAlign;                   ///< ELF: alignment for the text section.
-uint32_t    elfDataAlign;                   ///< ELF: alignment for the data section.
-bool        elfEntryPointStatus = FALSE;    ///< ELF: true once the entry point has been set.
-
-char        elfData[MAX_WORD_LENGTH];       ///< Small buffer for data bytes pushed into the data section.
-char        elfCode[MAX_WORD_LENGTH];       ///< Small buffer for instruction bytes pushed into the text section.
-int         elfDataLength;                  ///< Offset (write position) in the data memory area.
-bool        elfDataSectionStatus;           ///< True if data have already been placed in the data section (set vs. append).
-bool        elfCodeSectionStatus;           ///< True if text has already been placed in the text section (set vs. append).
-char*       elfBuffer;                      ///< Pointer to the allocated data buffer used for section building.
-int         elfBufferSize = 4096;           ///< Size of the data buffer allocated via malloc.
-
-char        func_entry[MAX_WORD_LENGTH];    ///< Name of the function currently being processed.
-bool        main_func_detected;             ///< True once a 'main' function (or equivalent) is detected.
-
-char        opchar[5][MAX_WORD_LENGTH];                  ///< Codegen staging: textual operands collected from the AST.
-int         opnum[5];                       ///< Codegen staging: numeric operands collected from the AST.
-char        option[2][MAX_WORD_LENGTH];                  ///< Codegen staging: instruction options/modifiers collected from the AST.
-int         opCount = 0;                    ///< Codegen staging: number of collected operands.
-int         optCount = 0;                   ///< Codegen staging: number of collected options.
-
-char        symPrint[132];                  ///< printf param for symtab print
-
-char        SourceFileName[MAX_FILE_NAME_LENGTH];            ///< Input source filename (.s / .asm).
-FILE* inputFile;                            ///< Open handle for the input source file.
+thread_local int         lineNr = 0;                     ///< Current source file line number (1-based).
+thread_local int         column;            ///< Column of the current token within the source line (0-based).
+thread_local const char* sl;                ///< Current source line: view into the mapped source, ends with '\n'.
+thread_local int         prgType;                        ///< Program type: 0 = undefined, 1 = standalone, 2 = module.
+thread_local char        token[MAX_WORD_LENGTH];         ///< Current token text.
+thread_local char        tokenSave[MAX_WORD_LENGTH];     ///< Previously seen token text (look-behind).
+thread_local const char* tokText;           ///< Lexer output: text of the token (not null-terminated).
+thread_local int         tokLen;            ///< Lexer output: length of tokText.
+thread_local uint32_t    tokId;             ///< Interned name ID of the current identifier token (0 = none).
+thread_local char        dataSegmentBase[8];             ///< Registername of actual data segment;
+thread_local char        baseRegData[5]; 
+thread_local char        currentSegment[50];             ///< actual code segment name
+thread_local int         tokTyp;            ///< Current token type (see TokenType).
+thread_local int         tokTypSave;                     ///< Previous token type (look-behind).
+thread_local int64_t     numToken;          ///< Value of a numeric token (evaluated once by the lexer).
+thread_local int64_t     value;                          ///< Evaluated numeric value from an expression.
+thread_local int         align_val;                      ///< Alignment value for directives that require alignment.
+thread_local int         mode;                           ///< Mode for arithmetic or addressing operations.
+thread_local bool        lineERR;                        ///< Flag: true if the current line is in error.
+thread_local bool        sourceERR = FALSE;                      ///< Flag: true if the source has an error.
+thread_local void      (*errorSink)(const char* msg) = NULL; ///< If set, processError() passes messages here instead of the SRC tree.
+thread_local char        label[MAX_WORD_LENGTH];         ///< Most recent label text.
+thread_local char        labelCodeOld[MAX_WORD_LENGTH];
+thread_local char        labelDataOld[MAX_WORD_LENGTH];
+thread_local char        currentCODE[MAX_WORD_LENGTH];
+thread_local uint32_t    currentCODEId;                  ///< Interned currentCODE (code section of new nodes).
+thread_local int         ind = 0;           ///< Scanner index into the source line during tokenization.
+thread_local char        opCode[MAX_WORD_LENGTH];        ///< Opcode mnemonic.
+thread_local int         opInstrType;                    ///< Opcode type (maps to opCodeTab[].instrType).
+thread_local int         operandType;                    ///< Operand classification used for AST construction.
+thread_local int         operandTyp[MAX_WORD_LENGTH];                 ///< Operand types used by code generation.
+thread_local int         directiveType;                  ///< Current directive kind (see Directives).
+thread_local char        dirCode[MAX_WORD_LENGTH];       ///< Directive mnemonic (as text).
+thread_local int         varType;                        ///< Variable classification: 0 = none, 1 = global, 2 = local.
+thread_local char        varName[MAX_WORD_LENGTH];       ///< Name of a global/local variable.
+thread_local char        buffer[MAX_LINE_LENGTH];                    ///< General-purpose text buffer.
+thread_local int64_t     symcodeAdr;                     ///< Code address associated with a symbol table entry.
+thread_local int         bin_status;                     ///< Binary status for instructions stored in SRC nodes.
+thread_local int         numOfInstructions=0;              ///< counter # of instruction bytes in segment
+thread_local int         numOfData;                      ///< counter # of data bytes in segment
+thread_local bool        addInstrGlob;                       ///< Flag is TRUE if during assembly additional instrtuctions generated globally
+thread_local bool        addInstrLine;                   ///< Flag is true if during assembly additional instrtuctions generated for actual source line
+thread_local bool        codeExist = FALSE;              ///< flag if a .CODE directive is present before first instruction    
+thread_local bool        dataExist = FALSE;              ///< flag if a .DATA directive is present before first definitin of byte,half,word etc.    
+thread_local int         numSegment = 0;                 ///< counter of segments for segment table
+
+thread_local char        errmsg[MAX_ERROR_LENGTH];       ///< Last error message text.
+thread_local char        infmsg[MAX_ERROR_LENGTH];       ///< Informational message (e.g., emitted by codegen).
+thread_local bool        is_label;                       ///< Parser helper: current statement starts with a label.
+thread_local bool        is_instruction;                 ///< Parser helper: current statement is an instruction.
+thread_local bool        is_directive;                   ///< Parser helper: current statement is a directive.
+thread_local bool        is_negative;                    ///< Parser helper: next numeric literal is negated.
+thread_local int         binInstr;                       ///< Current 32-bit binary instruction being emitted.
+thread_local int         binInstrSave;                   ///< Saved binary instruction (e.g., for large offset fixups).
+thread_local uint32_t         codeAdr;                        ///< Code address (text section address counter).
+thread_local uint32_t         dataAdr;                        ///< Data address (data section address counter).
+
+thread_local uint32_t    elfCodeAddr;                    ///< ELF: base virtual address of the text section.
+thread_local uint32_t    elfCodeAddrOld;
+thread_local uint32_t    elfDataAddr;                    ///< ELF: base virtual address of the data section.
+thread_local uint32_t    elfDataAddrOld;
+thread_local uint32_t    elfEntryPoint;                  ///< ELF: program entry point address.
+thread_local uint32_t    elfCodeAlign;                   ///< ELF: alignment for the text section.
+thread_local uint32_t    elfDataAlign;                   ///< ELF: alignment for the data section.
+thread_local bool        elfEntryPointStatus = FALSE;    ///< ELF: true once the entry point has been set.
+
+thread_local char        elfData[MAX_WORD_LENGTH];       ///< Small buffer for data bytes pushed into the data section.
+thread_local char        elfCode[MAX_WORD_LENGTH];       ///< Small buffer for instruction bytes pushed into the text section.
+thread_local int         elfDataLength;                  ///< Offset (write position) in the data memory area.
+thread_local bool        elfCodeSectionStatus;           ///< True if text has already been placed in the text section (set vs. append).
+
+thread_local char        func_entry[MAX_WORD_LENGTH];    ///< Name of the function currently being processed.
+thread_local bool        main_func_detected;             ///< True once a 'main' function (or equivalent) is detected.
+
+thread_local const char* opchar[5];                      ///< Codegen staging: operand texts of the current instruction record.
+thread_local int         opnum[5];                       ///< Codegen staging: numeric operands of the current instruction record.
+thread_local uint32_t    opId[5];                        ///< Codegen staging: interned operand names of the current instruction record.
+thread_local SymNode*    opSym[5];                       ///< Codegen staging: resolved label operands of the current instruction record.
+thread_local uint32_t    instrCodeAdr;                   ///< Codegen staging: parse-time address of the current instruction.
+thread_local uint32_t    instrSectionId;                 ///< Codegen staging: code section of the current instruction.
+thread_local const char* opBaseReg = "";                 ///< Codegen staging: base register of the current instruction.
+thread_local const char* option[2];                      ///< Codegen staging: instruction options/modifiers of the current instruction record.
+thread_local int         opCount = 0;                    ///< Codegen staging: number of collected operands.
+thread_local int         optCount = 0;                   ///< Codegen staging: number of collected options.
+
+thread_local char        symPrint[132];                  ///< printf param for symtab print
+
+thread_local char        SourceFileName[MAX_FILE_NAME_LENGTH];            ///< Input source filename (.s / .asm).
+thread_local char*       srcBuf = NULL;                  ///< Contents of the input source file (memory mapping or heap copy).
+thread_local size_t      srcLen = 0;                     ///< Size of the input source file in bytes.
+thread_local bool        srcMapped = FALSE;              ///< True if srcBuf is a memory mapping.
 
 // --------------------------------------------------------------------------------
 //      Debug switches
@@ -119,26 +132,33 @@ bool DBG_AST = FALSE;  ///< Dump abstract syntax tree after parsing.
 bool DBG_SEGMENT = TRUE; ///< Dump segment table
 bool DBG_SOURCE = TRUE;  ///< Print source listing with addresses and binary.
 bool DBG_ELF = TRUE;     ///< Dump ELF file
+int DBG_ELF_PARTS = ELF_DUMP_ALL;   ///< Parts of the ELF dump (ELF_DUMP_ flags).
+const char* DBG_ELF_SECTION = NULL; ///< Section whose contents are dumped (NULL: all).
+int DBG_ELF_BYTES = 256;            ///< Bytes dumped per section at most (0: no limit).
 
 // --------------------------------------------------------------------------------
-/** \name Token list
- *  \brief Linked list built by the lexer and consumed by the parser.
+/** \name Token stream
+ *  \brief Contiguous token array built by the lexer and consumed by the parser.
  */
  // --------------------------------------------------------------------------------
 
-struct tokenList* next_t = NULL;            ///< Tail insertion helper.
-struct tokenList* start_t = NULL;           ///< Head of the token list.
-struct tokenList* ptr_t;                    ///< Iteration pointer over the token list.
+thread_local struct tokenEntry* tokenTab = NULL;         ///< Token array (grows geometrically).
+thread_local int         tokenCount = 0;                 ///< Number of tokens in the array.
+thread_local int         tokenCapacity = 0;              ///< Allocated entries.
+thread_local int         tokenIndex = 0;                 ///< Parser position in the array.
+thread_local struct tokenEntry* ptr_t;                   ///< Current token (getToken(tokenIndex)).
+bool        streamMode = FALSE;             ///< Flag: lexer and parser run concurrently on a token ring.
+int         codegenThreads = 0;             ///< Code generation threads; 0: one per core for large programs.
 
 // --------------------------------------------------------------------------------
-/** \name BIN list
- *  \brief Linked list built by the codegenfrom AST and consumed by the ELF adn SRC list
+/** \name BIN sections
+ *  \brief Instruction words built by the codegen and consumed by the ELF and SRC list
  */
  // --------------------------------------------------------------------------------
 
-struct BINList* next_b = NULL;         ///< Next BIN pointer
-struct BINList* start_b = NULL;        ///< Start of BIN list
-struct BINList* ptr_b;          ///< General BIN pointer
+thread_local struct BINSection* binTab = NULL;      ///< Code sections in source order
+thread_local int binCount = 0;                      ///< Number of sections in binTab
+thread_local int binCapacity = 0;                   ///< Allocated entries in binTab
 
 // --------------------------------------------------------------------------------
 /** \name Symbol table
@@ -146,28 +166,29 @@ struct BINList* ptr_b;          ///< General BIN pointer
  */
  // --------------------------------------------------------------------------------
 
-SymNode* scopeTab[10];                      ///< Scope stack: one pointer per nested level.
-char        scopeNameTab[50][10];           ///< Human-readable scope names by level.
-int         currentScopeLevel;              ///< Current depth of the scope stack.
-int         searchScopeLevel;               ///< Search depth used by symbol lookup.
-int         maxScopeLevel = 4;              ///< Maximum supported nested scope depth.
-char        currentScopeName[50];           ///< Label/name of the current scope.
-char        currentScopeNameSave[50];       ///< Saved scope name (temporary).
-SYM_ScopeType currentScopeType;             ///< Current scope type (see ::SYM_ScopeType).
-
-bool        symFound = FALSE;               ///< Result flag for symbol searches.
-SymNode* GlobalSYM = NULL;                  ///< Root/global scope node.
-SymNode* program = NULL;                    ///< Program-level scope node.
-SymNode* module = NULL;                     ///< Module-level scope node.
-SymNode* function = NULL;                   ///< Function-level scope node.
-SymNode* block = NULL;                      ///< Block/local scope node.
-SymNode* directive = NULL;                  ///< Directive scope node.
-SymNode* currentSym = NULL;                 ///< Current symbol node (context-dependent).
-SymNode* currentSymSave = NULL;             ///< Saved symbol node (temporary).
-
-char        symFunc[50];                    ///< Symbol "function"/kind stored in the symbol table (e.g., PROGRAM, REG).
-char        symValue[50];                   ///< Symbol value stored in the symbol table (textual form).
-char        symDataSegmentBase[5];
+thread_local SymNode* scopeTab[10];                      ///< Scope stack: one pointer per nested level.
+thread_local char        scopeNameTab[50][10];           ///< Human-readable scope names by level.
+thread_local int         currentScopeLevel;              ///< Current depth of the scope stack.
+thread_local int         searchScopeLevel;               ///< Search depth used by symbol lookup.
+thread_local int         maxScopeLevel = 4;              ///< Maximum supported nested scope depth.
+thread_local char        currentScopeName[50];           ///< Label/name of the current scope.
+thread_local uint32_t    currentScopeId;                 ///< Interned currentScopeName (maintained by codegen).
+thread_local char        currentScopeNameSave[50];       ///< Saved scope name (temporary).
+thread_local SYM_ScopeType currentScopeType;             ///< Current scope type (see ::SYM_ScopeType).
+
+thread_local bool        symFound = FALSE;               ///< Result flag for symbol searches.
+thread_local SymNode* GlobalSYM = NULL;                  ///< Root/global scope node.
+thread_local SymNode* program = NULL;                    ///< Program-level scope node.
+thread_local SymNode* module = NULL;                     ///< Module-level scope node.
+thread_local SymNode* function = NULL;                   ///< Function-level scope node.
+thread_local SymNode* block = NULL;                      ///< Block/local scope node.
+thread_local SymNode* directive = NULL;                  ///< Directive scope node.
+thread_local SymNode* currentSym = NULL;                 ///< Current symbol node (context-dependent).
+
+thread_local char        symFunc[50];                    ///< Symbol "function"/kind stored in the symbol table (e.g., PROGRAM, REG).
+thread_local char        symValue[50];                   ///< Symbol value stored in the symbol table (textual form).
+thread_local int64_t     symNumValue;                    ///< Evaluated symbol value (EQU constants).
+thread_local char        symDataSegmentBase[5];
 
 // --------------------------------------------------------------------------------
 /** \name Abstract Syntax Tree (AST)
@@ -175,22 +196,22 @@ char        symDataSegmentBase[5];
  */
  // --------------------------------------------------------------------------------
 
-ASTNode* ASTprogram = NULL;
-ASTNode* ASTinstruction = NULL;
-ASTNode* ASTdirective = NULL;
-ASTNode* ASTcode = NULL;
-ASTNode* ASToperation = NULL;
-ASTNode* ASTop1 = NULL;
-ASTNode* ASTop2 = NULL;
-ASTNode* ASTop3 = NULL;
-ASTNode* ASTop4 = NULL;
-ASTNode* ASTlabel = NULL;
-ASTNode* ASTmode = NULL;
-ASTNode* ASTopt1 = NULL;
-ASTNode* ASTopt2 = NULL;
-ASTNode* ASTaddr = NULL;
-ASTNode* ASTalign = NULL;
-ASTNode* ASTentry = NULL;
+thread_local ASTNode* ASTprogram = NULL;
+thread_local ASTNode* ASTinstruction = NULL;
+thread_local ASTNode* ASTdirective = NULL;
+thread_local ASTNode* ASTcode = NULL;
+thread_local ASTNode* ASToperation = NULL;
+thread_local ASTNode* ASTop1 = NULL;
+thread_local ASTNode* ASTop2 = NULL;
+thread_local ASTNode* ASTop3 = NULL;
+thread_local ASTNode* ASTop4 = NULL;
+thread_local ASTNode* ASTlabel = NULL;
+thread_local ASTNode* ASTmode = NULL;
+thread_local ASTNode* ASTopt1 = NULL;
+thread_local ASTNode* ASTopt2 = NULL;
+thread_local ASTNode* ASTaddr = NULL;
+thread_local ASTNode* ASTalign = NULL;
+thread_local ASTNode* ASTentry = NULL;
 
 
 // --------------------------------------------------------------------------------
@@ -199,21 +220,32 @@ ASTNode* ASTentry = NULL;
  */
  // --------------------------------------------------------------------------------
 
-SRC_NodeType currentSRC_type;               ///< Helper for building/printing the source tree.
-SRCNode* SRCLINE = NULL;                    ///< (unused placeholder) line node.
-SRCNode* SRCTEXT = NULL;                    ///< (unused placeholder) text node.
-SRCNode* GlobalSRC = NULL;                  ///< Root node for the program’s source listing.
-SRCNode* SRCprogram = NULL;                 ///< Program node in the source listing.
-SRCNode* SRCsource = NULL;                  ///< One node per input source line.
-SRCNode* SRCbin = NULL;                     ///< Node for additional binary rows (e.g., emitted by pseudo-ops).
-SRCNode* SRCerror = NULL;                   ///< Node representing an error message.
-SRCNode* SRCcurrent = NULL;                 ///< Scratch pointer used when updating nodes.
+thread_local SRC_NodeType currentSRC_type;               ///< Helper for building/printing the source tree.
+thread_local SRCNode* SRCLINE = NULL;                    ///< (unused placeholder) line node.
+thread_local SRCNode* SRCTEXT = NULL;                    ///< (unused placeholder) text node.
+thread_local SRCNode* GlobalSRC = NULL;                  ///< Root node for the program’s source listing.
+thread_local SRCNode* SRCprogram = NULL;                 ///< Program node in the source listing.
+thread_local SRCNode* SRCsource = NULL;                  ///< One node per input source line.
+thread_local SRCNode* SRCbin = NULL;                     ///< Node for additional binary rows (e.g., emitted by pseudo-ops).
+thread_local SRCNode* SRCerror = NULL;                   ///< Node representing an error message.
+thread_local SRCNode* SRCcurrent = NULL;                 ///< Scratch pointer used when updating nodes.
+thread_local SRCNode* srcLineTab = NULL;                 ///< Contiguous source line records (line n at index n - 1).
+thread_local int      srcLineCount = 0;                  ///< Number of source line records.
+thread_local int      srcLineCapacity = 0;               ///< Allocated entries in srcLineTab.
+
+thread_local struct arena astArena = {};                 ///< AST nodes, released once code generation is done.
+thread_local struct arena symArena = {};                 ///< Symbol table nodes.
+thread_local struct arena srcArena = {};                 ///< SRC nodes and their message texts.
+thread_local struct interner* internTab = NULL;          ///< Interned names; set on every thread working for the assembly.
+
+thread_local struct instrRecord* instrTab = NULL;        ///< Instruction and code section records, in source order.
+thread_local int      instrCount = 0;                    ///< Number of records in instrTab.
 
 // --------------------------------------------------------------------------------
 //      Subroutines
 // --------------------------------------------------------------------------------
 
-SegmentTableEntry table[MAX_ENTRIES];
+thread_local SegmentTableEntry table[MAX_ENTRIES];
 
 // --------------------------------------------------------------------------------
 //      Subroutines
@@ -222,14 +254,13 @@ SegmentTableEntry table[MAX_ENTRIES];
 
 void printBIN() {
 
-    ptr_b = start_b;
-
-    while (ptr_b != NULL) {
+    for (int s = 0; s < binCount; s++) {
+        struct BINSection* sec = &binTab[s];
 
-        printf("Type %d lineNr %d CodeAdr %x Instr %x BINSTAT %d\n", ptr_b->b_type, ptr_b->b_lineNr, ptr_b->b_codeAdr, ptr_b->b_binInstr, ptr_b->b_bin_status);
+        printf("Section %s lineNr %d Addr %x Words %d Notes %d\n", internText(sec->b_nameId), sec->b_lineNr, sec->b_addr, sec->b_count, sec->b_noteCount);
 
-        if (ptr_b != NULL) {
-            ptr_b = ptr_b->next;
+        for (int i = 0; i < sec->b_count; i++) {
+            printf("Instr %x\n", sec->b_code[i]);
         }
     }
 }
@@ -355,17 +386,54 @@ void setDefaultDirectives() {
 /// \param type Classification of the node (see ::SRC_NodeType).
 /// \param text Display text (typically the raw source line or a message).
 /// \param lineNr Line number associated with this node (0 for the root/program).
-/// \return Pointer to the allocated node (owned by the caller).
+/// \return Pointer to the node (node and text live in ::srcArena).
 SRCNode* createSRCnode(SRC_NodeType type, const char* text, int lineNr) {
-    SRCNode* node = (SRCNode*)malloc(sizeof(SRCNode));
+    SRCNode* node = (SRCNode*)arenaAlloc(&srcArena, sizeof(SRCNode));
 
-    if (node == NULL) {
-        fatalError("malloc failed");
-    }
     node->s_type = type;
     node->s_lineNr = lineNr;
     node->s_binStatus = bin_status;
-    node->s_text = strdup(text);
+    node->s_text = arenaText(&srcArena, text);
+    node->s_textLen = strlen(text);
+    node->children = NULL;
+    node->s_childCount = 0;
+    node->s_codeAdr = codeAdr;
+    return node;
+}
+
+/// \brief Append the record for one line of the source file.
+/// \param offset Offset of the line inside the source mapping.
+/// \param len Length of the line without its terminating newline.
+/// \param lineNr Line number of the line (lines are appended in order).
+/// \return Pointer to the record in ::srcLineTab.
+/// \details
+/// Line records live in one contiguous array that grows geometrically, so
+/// adding a line allocates nothing per line and the text is never copied;
+/// the listing reads it from ::srcBuf. Pointers to a record are only valid
+/// until the next line is appended (::SRCcurrent is kept up to date).
+SRCNode* createSRCline(size_t offset, int len, int lineNr) {
+    if (srcLineCount == srcLineCapacity) {
+        // Keep SRCcurrent valid when the table moves (streaming mode appends
+        // lines while the parser is running).
+        ptrdiff_t current = (SRCcurrent >= srcLineTab && SRCcurrent < srcLineTab + srcLineCount) ? SRCcurrent - srcLineTab : -1;
+
+        srcLineCapacity = (srcLineCapacity == 0) ? 1024 : srcLineCapacity * 2;
+        srcLineTab = (SRCNode*)realloc(srcLineTab, sizeof(SRCNode) * srcLineCapacity);
+        if (srcLineTab == NULL) {
+            fatalError("realloc failed");
+        }
+        if (current >= 0) {
+            SRCcurrent = srcLineTab + current;
+        }
+    }
+    SRCNode* node = &srcLineTab[srcLineCount++];
+
+    node->s_type = SRC_SOURCE;
+    node->s_lineNr = lineNr;
+    node->s_binStatus = bin_status;
+    node->s_text = NULL;
+    node->s_textLen = len;
+    node->s_offset = offset;
     node->children = NULL;
     node->s_childCount = 0;
     node->s_codeAdr = codeAdr;
@@ -374,57 +442,47 @@ SRCNode* createSRCnode(SRC_NodeType type, const char* text, int lineNr) {
 
 /// \brief Append a child to a parent node in the source tree.
 /// \param parent Parent node to receive the child.
-/// \param child Child node to append (ownership transferred).
+/// \param child Child node to append.
 void addSRCchild(SRCNode* parent, SRCNode* child) {
-    parent->children = (SRCNode**)realloc(parent->children, sizeof(SRCNode*) * (parent->s_childCount + 1));
-    if (parent->children == NULL) {
-        fatalError("realloc failed");
-    }
+    parent->children = (SRCNode**)arenaSpan(&srcArena, parent->children, parent->s_childCount, sizeof(SRCNode*));
     parent->children[parent->s_childCount++] = child;
 }
 
-/// \brief Locate the current source node (matching ::lineNr) within the source tree.
+/// \brief Return the source line record of a line.
+/// \param lineNr Line number (1 = first line).
+/// \return The record in ::srcLineTab, or NULL if the line has not been read.
 /// \details
-/// On match, sets the global ::SRCcurrent to the node found.
-/// \param node Subtree root to search.
-/// \param depth Current recursion depth (informational).
-void searchSRC(SRCNode* node, int depth) {
-
-    if (!node) return;
-
-    if (node->s_type == SRC_SOURCE &&
-        node->s_lineNr == lineNr) {
-        SRCcurrent = node;
+/// Every `SRC_SOURCE` node is a line record and line n is kept at index
+/// n - 1, so the lookup is a plain index.
+SRCNode* findSRCline(int lineNr) {
+    if (lineNr < 1 || lineNr > srcLineCount) {
+        return NULL;
     }
+    return &srcLineTab[lineNr - 1];
+}
 
-    for (int i = 0; i < node->s_childCount; i++) {
-        searchSRC(node->children[i], depth + 1);
+/// \brief Locate the current source node (matching ::lineNr).
+/// \details
+/// On match, sets the global ::SRCcurrent to the node found; otherwise
+/// ::SRCcurrent is left unchanged.
+void searchSRC() {
+    SRCNode* node = findSRCline(lineNr);
+    if (node != NULL) {
+        SRCcurrent = node;
     }
-
 }
 
 /// \brief Insert the current binary instruction into the matching source node.
 /// \details
 /// For the current ::lineNr, stores the code address, binary instruction,
-/// and binary status on the corresponding SRC node and eligible BIN child nodes.
-/// \param node Subtree root to update.
-/// \param depth Current recursion depth (informational).
-void insertBinToSRC(SRCNode* node, int depth) {
-
-    if (!node) return;
-
-    if (node->s_type == SRC_SOURCE &&
-        node->s_lineNr == lineNr) {
-
+/// and binary status on the corresponding source line record.
+void insertBinToSRC() {
+    SRCNode* node = findSRCline(lineNr);
+    if (node != NULL) {
         node->s_codeAdr = codeAdr - 4;
         node->s_binInstr = binInstr;
         node->s_binStatus = bin_status;
     }
-
-    for (int i = 0; i < node->s_childCount; i++) {
-        insertBinToSRC(node->children[i], depth + 1);
-    }
-
 }
 
 /// \brief Print the hierarchical source listing with addresses, binaries, and diagnostics.
@@ -436,30 +494,30 @@ void printSourceListing(SRCNode* node, int depth) {
 
     if (node->s_lineNr != 0) {
         if (node->s_type == SRC_ERROR) {
-            printf("                        Error->\t%s\n", node->s_text);
+            printf("                        Error->\t%.*s\n", node->s_textLen, node->s_text);
         }
         else if (node->s_type == SRC_WARNING) {
-            printf("                        W: \t%s", node->s_text);
+            printf("                        W: \t%.*s", node->s_textLen, node->s_text);
         }
         else if (node->s_type == SRC_SOURCE &&
             node->s_binStatus == B_BIN) {
-            printf(" %08x %08x %4d %s", node->s_codeAdr, node->s_binInstr, node->s_lineNr, node->s_text);
+            printf(" %08x %08x %4d %.*s\n", node->s_codeAdr, node->s_binInstr, node->s_lineNr, node->s_textLen, srcBuf + node->s_offset);
         }
         else if (node->s_type == SRC_BIN &&
             node->s_binStatus == B_BINCHILD) {
-            printf(" %08x %08x %4d %s", node->s_codeAdr, node->s_binInstr, node->s_lineNr, node->s_text);
+            printf(" %08x %08x %4d %.*s", node->s_codeAdr, node->s_binInstr, node->s_lineNr, node->s_textLen, node->s_text);
         }
         else if (node->s_type == SRC_SOURCE &&
             node->s_binStatus == B_NOBIN) {
-            printf("                   %4d %s", node->s_lineNr, node->s_text);
+            printf("                   %4d %.*s\n", node->s_lineNr, node->s_textLen, srcBuf + node->s_offset);
         }
         else if (node->s_type == SRC_INFO) {
-            printf("                        I:  %s", node->s_text);
+            printf("                        I:  %.*s", node->s_textLen, node->s_text);
         }
     }
     else {
 
-        printf("Program: %s", node->s_text);
+        printf("Program: %.*s", node->s_textLen, node->s_text);
         printf("--------------------------------------------------------------------------------------\n");
         printf("CAdr Code       Line Source\n");
         printf("+------------------------------------------------------------------------------------+ \n");
@@ -469,66 +527,54 @@ void printSourceListing(SRCNode* node, int depth) {
     for (int i = 0; i < node->s_childCount; i++) {
         printSourceListing(node->children[i], depth + 1);
     }
-}
-
-/// \brief Copy binary instructions from the source tree into ELF sections.
-/// \param node Subtree root to read from.
-/// \param depth Current recursion depth (informational).
-void copyToELF(SRCNode* node, int depth) {
-    return;
-
-    if (!node) return;
-
-    if (node->s_lineNr != 0) {
-
-        if (node->s_type == SRC_SOURCE &&
-            node->s_binStatus == B_BIN) {
-            elfCode[0] = (node->s_binInstr >> 24) & 0xFF;
-            elfCode[1] = (node->s_binInstr >> 16) & 0xFF;
-            elfCode[2] = (node->s_binInstr >> 8) & 0xFF;
-            elfCode[3] = node->s_binInstr & 0xFF;
-            addTextSectionData();
-        }
-        else if (node->s_type == SRC_BIN &&
-            node->s_binStatus == B_BINCHILD) {
-            elfCode[0] = (node->s_binInstr >> 24) & 0xFF;
-            elfCode[1] = (node->s_binInstr >> 16) & 0xFF;
-            elfCode[2] = (node->s_binInstr >> 8) & 0xFF;
-            elfCode[3] = node->s_binInstr & 0xFF;
-            addTextSectionData();
+    if (node == GlobalSRC) {
+        for (int i = 0; i < srcLineCount; i++) {
+            printSourceListing(&srcLineTab[i], depth + 1);
         }
     }
-    for (int i = 0; i < node->s_childCount; i++) {
-        copyToELF(node->children[i], depth + 1);
-    }
 }
 
 // -------------------------------------------------------------------------------- 
-//  Main Routine
+//  Assembly
 // --------------------------------------------------------------------------------
 
-/// \brief Program entry point.
+/// \brief Free everything the current assembly still holds.
+/// \details
+/// Runs at the end of every assembly, also when it was abandoned by a fatal
+/// error, so that the assembling thread leaves no memory or mapping behind.
+static void releaseAssembly() {
+    releaseLexer();
+    releaseParser();
+    releaseCodegen();
+    releaseELF();
+    arenaRelease(&astArena);
+    arenaRelease(&symArena);
+    arenaRelease(&srcArena);
+    free(srcLineTab);
+    srcLineTab = NULL;
+    srcLineCount = srcLineCapacity = 0;
+    if (srcBuf != NULL) {
+        closeSourceFile();
+    }
+    releaseInterner(internTab);
+    internTab = NULL;
+}
+
+/// \brief Assemble one source file on the calling thread.
 /// \details
-/// Expected usage: `asm32 <filename>`.
 /// The assembler performs:
-/// 1) Lexing (build token list),
+/// 1) Lexing (build token list; with `-s` the lexer runs on its own thread
+///    and streams tokens to the parser through a bounded ring buffer),
 /// 2) Parsing (build AST),
 /// 3) Code generation (emit binary, build SRC tree),
 /// 4) ELF construction and file emission,
 /// 5) Optional diagnostics: tokens, AST, symbol table, source listing.
-int main(int argc, char** argv) {
-
-    if (argc != 2) {
-        printf("Usage: %s <filename>\n", argv[0]);
-        return 1;
-    }
-    if (argv[1] == NULL) {
-        printf("Usage: %s <filename>\n", argv[0]);
-        return 1;
-    }
+/// Expects the freshly initialized thread-local state of a new thread.
+/// \return 0 if the ELF file was written, 1 otherwise.
+static int assemble(const char* fileName) {
 
-
-    strcpy(SourceFileName, argv[1]);
+    snprintf(SourceFileName, sizeof(SourceFileName), "%s", fileName);
+    internTab = createInterner();
     openSourceFile();
 
     printf("\n\nAssembler start %s\n\n", VERSION);
@@ -540,9 +586,12 @@ int main(int argc, char** argv) {
 
     // --------------------------------------------------------------------------------
     //  Lexer
-    //  Reads the source file and generates a linked list of tokens.
+    //  Scans the mapped source file (in parallel chunks for large files) and
+    //  generates the token stream. Lines and tokens refer to the mapping;
+    //  nothing is copied.
     // --------------------------------------------------------------------------------
 
+    initScanner();
     lineNr = 1;
     main_func_detected = FALSE;
     prgType = P_UNDEFINED;        // Program type not yet defined.
@@ -551,45 +600,13 @@ int main(int argc, char** argv) {
     strcat(buffer, "\n");
     GlobalSRC = createSRCnode(SRC_PROGRAM, buffer, 0);
 
-    while (TRUE) {
-
-        ind = 0;
-        int j = 0;
-        tokTyp = NONE;
-        fgets(sl, MAX_LINE_LENGTH, inputFile);
-
-        // Push the source line into the linked list structure.
-
-        if (feof(inputFile) != 0) {
-            break;
-        }
-
-        // Create a SRC node for the raw source line.
-        strcpy(buffer, sl);
-        SRCsource = createSRCnode(SRC_SOURCE, buffer, lineNr);
-        addSRCchild(GlobalSRC, SRCsource);
-
-        // Tokenize the current line.
-        while (tokTyp != T_EOL) {
-            createToken();
-            createTokenEntry();
-            ptr_t->t_lineNr = lineNr;
-            ptr_t->t_column = column + 1;
-            strcpy(ptr_t->t_token, token);
-            ptr_t->t_tokTyp = tokTyp;
-        }
-
-        lineNr++;
+    if (streamMode == TRUE) {
+        startTokenStream();
+    }
+    else {
+        lexSourceFile();
+        printTokenList();
     }
-
-    // Append explicit end-of-input token.
-    createTokenEntry();
-    ptr_t->t_lineNr = lineNr;
-    ptr_t->t_column = 0;
-    strcpy(ptr_t->t_token, "");
-    ptr_t->t_tokTyp = EOF;
-
-    printTokenList();
 
     // --------------------------------------------------------------------------------
     //  Parser
@@ -601,7 +618,6 @@ int main(int argc, char** argv) {
     // --------------------------------------------------------------------------------
     createELF();
 
-    elfDataSectionStatus = FALSE;
     elfCodeSectionStatus = FALSE;
 
     if (DBG_PARSER) {
@@ -615,8 +631,10 @@ int main(int argc, char** argv) {
     strcpy(label, "GLOBAL");
     strcpy(symFunc, "");
     strcpy(symValue, "");
+    currentCODEId = internString(currentCODE);
     GlobalSYM = createSYMnode(SCOPE_PROGRAM, label, symFunc, SourceFileName, 0);
     scopeTab[currentScopeLevel] = GlobalSYM;
+    addSYMhash(GlobalSYM);
 
     // Optionally add program scope here:
     // strcpy(label, "P1");
@@ -627,16 +645,18 @@ int main(int argc, char** argv) {
 
     currentScopeType = SCOPE_PROGRAM;
 
-    ptr_t = start_t;
+    tokenIndex = 0;
     codeAdr = 0;
     dataAdr = 0;
 
-    while (ptr_t != NULL) {
+    while (hasToken(tokenIndex)) {
+
+        ptr_t = getToken(tokenIndex);
 
         is_label = FALSE;
         is_instruction = FALSE;
         is_directive = FALSE;
-        strcpy(tokenSave, ptr_t->t_token);
+        getTokenText(ptr_t, tokenSave);
 
         if (ptr_t->t_tokTyp == T_IDENTIFIER) {
             fetchToken();
@@ -650,7 +670,7 @@ int main(int argc, char** argv) {
         else if (ptr_t->t_tokTyp == T_DOT) {
             fetchToken();
             if (tokTyp == T_IDENTIFIER) {
-                strcpy(tokenSave, ptr_t->t_token);
+                getTokenText(ptr_t, tokenSave);
                 is_directive = TRUE;
             }
         }
@@ -668,48 +688,35 @@ int main(int argc, char** argv) {
 
         if (lineERR == TRUE) {
             // Skip to end of line after an error to resynchronize.
-            while (ptr_t->t_tokTyp != T_EOL) {
-                ptr_t = ptr_t->next;
-                if (ptr_t == NULL)  break;
+            while (getToken(tokenIndex)->t_tokTyp != T_EOL) {
+                tokenIndex++;
+                if (!hasToken(tokenIndex))  break;
             }
         }
 
-        if (ptr_t != NULL) {
-            ptr_t = ptr_t->next;
-        }
+        tokenIndex++;
+    }
+    if (streamMode == TRUE) {
+        finishTokenStream();
     }
 
-    // Insert a dummy instruction at the end to ensure complete processing.
-    operandType = 0;
-    ASTinstruction = createASTnode(NODE_INSTRUCTION, "", binInstr);
-    addASTchild(ASTprogram, ASTinstruction);
+    // Bind the label operands that referred to labels defined later.
+    resolveLabelRefs();
 
     // --------------------------------------------------------------------------------
     //  Codegen
-    //  Traverses the AST and emits binary code.
+    //  Walks the instruction records once and emits binary code. Instructions
+    //  that need an ADDIL expansion grow while they are encoded; branch offsets
+    //  to labels are filled in afterwards, when the final label addresses are
+    //  known.
     // --------------------------------------------------------------------------------
 
     binInstr = 0;
     codeAdr = 0;
-    addInstrGlob = TRUE;
+    addInstrGlob = FALSE;
 
-    int numAST = 0;
-    while (addInstrGlob == TRUE) {
-        addInstrGlob = FALSE;
-        processAST(ASTprogram, 0);
-        numAST++;
-
-        if (addInstrGlob == TRUE) {
-            deleteBIN();
-            start_b = NULL;
-            codeAdr = 0;
-            nodeTypeOld = 0;
-
-        }
-    }
-    printf("# of AST runs required:  %d\n", numAST);
-    
-    // jetzt ist BINList fertig
+    processInstructions();
+    resolveBranchFixups();
 
     processBIN();
 
@@ -764,6 +771,13 @@ int main(int argc, char** argv) {
         printAST(ASTprogram, 0);
     }
 
+    // The AST and the instruction records are not needed after code generation.
+    arenaRelease(&astArena);
+    ASTprogram = NULL;
+    free(instrTab);
+    instrTab = NULL;
+    instrCount = 0;
+
     
     qsort(table, numSegment, sizeof(SegmentTableEntry), compareByAddr);
 
@@ -797,6 +811,15 @@ int main(int argc, char** argv) {
 
     
 
+    // Symbol table and listing are complete, give them back in one go.
+    arenaRelease(&symArena);
+    arenaRelease(&srcArena);
+    free(srcLineTab);
+    srcLineTab = NULL;
+    srcLineCount = srcLineCapacity = 0;
+    GlobalSYM = NULL;
+    GlobalSRC = NULL;
+
     closeSourceFile();
 
     // -------------------------------------------------------------------------------- 
@@ -807,40 +830,158 @@ int main(int argc, char** argv) {
         addNote();
         char output[MAX_FILE_NAME_LENGTH];
         changeExtension2Out(SourceFileName, output, sizeof(output));
-        writeElfFile(output);
+        if (writeElfFile(output) != 0) {
+            return 1;
+        }
 
         if (DBG_ELF == TRUE) {
             printf("\n\n+------------------------------------------------------------------------------------+\n");
             printf("|                           ELF FILE                                                 |\n");
             printf("+------------------------------------------------------------------------------------+ \n");
 
-            elfio reader;
-
-            if (!reader.load("ASM32.out")) {
-                printf("File %s is not found or it is not an ELF file\n", argv[1]);
-                return 1;
-            }
-
-            dump::header(std::cout, reader);
-            dump::section_headers(std::cout, reader);
-            dump::segment_headers(std::cout, reader);
-            dump::symbol_tables(std::cout, reader);
-            dump::notes(std::cout, reader);
-            dump::modinfo(std::cout, reader);
-            dump::dynamic_tags(std::cout, reader);
-            dump::section_datas(std::cout, reader);
-            dump::segment_datas(std::cout, reader);
+            dumpElf(DBG_ELF_PARTS, DBG_ELF_SECTION, DBG_ELF_BYTES);
         }
     }
     else {
         printf("\n\n+------------------------------------------------------------------------------------+\n");
         printf("|         no ELF File written due to error                                           |\n");
         printf("+------------------------------------------------------------------------------------+ \n");
+        return 1;
+    }
+    return 0;
+}
 
+/// \brief Assemble one source file.
+/// \param fileName Name of the source file; the ELF file gets the extension `.out`.
+/// \return 0 if the ELF file was written, 1 if the source has errors,
+///         255 if the assembly was abandoned by a fatal error.
+/// \details
+/// The assembly runs on a thread of its own and starts with fresh
+/// thread-local state, so any number of files can be assembled one after
+/// the other or concurrently from different threads of one process. The
+/// tables, the interned names and the source mapping of the assembly are
+/// released before the function returns. Any other exception (out of
+/// memory, elfio) abandons the assembly like a fatal error; it is reported
+/// on the calling thread.
+int assembleFile(const char* fileName) {
+    int status = 255;
+    std::exception_ptr failure;
+    std::thread assembler([&]() {
+        try {
+            status = assemble(fileName);
+        }
+        catch (const assemblyAbort&) {
+            status = 255;
+        }
+        catch (...) {
+            status = 255;
+            failure = std::current_exception();
+        }
+        releaseAssembly();
+    });
+    assembler.join();
+
+    if (failure) {
+        try {
+            std::rethrow_exception(failure);
+        }
+        catch (const std::exception& e) {
+            printf("Fatal Error> %s\n", e.what());
+        }
+        catch (...) {
+            printf("Fatal Error> unknown exception\n");
+        }
+        printf("\n----- ASM32 Assembler terminated -----\n");
     }
-    exit(0);
+    return status;
+}
 
-    // -------------------------------------------------------------------------------- 
-    //  END of MAIN Routine
-    // --------------------------------------------------------------------------------
+// -------------------------------------------------------------------------------- 
+//  Main Routine
+// --------------------------------------------------------------------------------
+
+/// \brief Print the command line syntax.
+static void printUsage(const char* prog) {
+    printf("Usage: %s [-s] [-j <threads>] [-e none|headers|all|<section>] [-b <bytes>] <filename>...\n", prog);
+}
+
+/// \brief Program entry point.
+/// \details
+/// Expected usage: `asm32 [-s] [-j <threads>] [-e <part>] [-b <bytes>] <filename>...`.
+/// `-j` sets the number of code generation threads, also for programs too
+/// small to be encoded in parallel otherwise (1: encode on the assembling
+/// thread). `-e` selects the ELF dump: `none`, `headers`, `all` or the name of one
+/// section whose contents are dumped; `-b` caps the bytes dumped per
+/// section (0: no limit). A missing or invalid option value prints the
+/// usage.
+/// The files are assembled one after the other within this process.
+/// \return The highest status returned by assembleFile().
+int main(int argc, char** argv) {
+
+    int argi = 1;
+    while (argi < argc && argv[argi][0] == '-') {
+        if (strcmp(argv[argi], "-s") == 0) {
+            streamMode = TRUE;
+            argi++;
+        }
+        else if (strcmp(argv[argi], "-j") == 0) {
+            char* end = NULL;
+            long threads = (argi + 1 < argc) ? strtol(argv[argi + 1], &end, 10) : -1;
+            if (end == NULL || end == argv[argi + 1] || *end != '\0' || threads < 1 || threads > 256) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            codegenThreads = (int)threads;
+            argi += 2;
+        }
+        else if (strcmp(argv[argi], "-e") == 0) {
+            if (argi + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            const char* part = argv[argi + 1];
+            DBG_ELF = TRUE;
+            DBG_ELF_SECTION = NULL;
+            if (strcmp(part, "none") == 0) {
+                DBG_ELF = FALSE;
+            }
+            else if (strcmp(part, "headers") == 0) {
+                DBG_ELF_PARTS = ELF_DUMP_HEADERS;
+            }
+            else if (strcmp(part, "all") == 0) {
+                DBG_ELF_PARTS = ELF_DUMP_ALL;
+            }
+            else {
+                DBG_ELF_PARTS = ELF_DUMP_DATA;
+                DBG_ELF_SECTION = part;
+            }
+            argi += 2;
+        }
+        else if (strcmp(argv[argi], "-b") == 0) {
+            char* end = NULL;
+            long bytes = (argi + 1 < argc) ? strtol(argv[argi + 1], &end, 10) : -1;
+            if (end == NULL || end == argv[argi + 1] || *end != '\0' || bytes < 0 || bytes > INT32_MAX) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            DBG_ELF_BYTES = (int)bytes;
+            argi += 2;
+        }
+        else {
+            break;
+        }
+    }
+    if (argc < argi + 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = argi; i < argc; i++) {
+        int fileStatus = assembleFile(argv[i]);
+        if (fileStatus > status) {
+            status = fileStatus;
+        }
+    }
+    return status;
 }
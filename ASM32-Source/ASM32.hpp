@@ -17,101 +17,107 @@
 // Global Variables
 // ============================================================================
 
-extern char  SourceFileName[MAX_FILE_NAME_LENGTH];             ///< Name of the input source file
-extern FILE* inputFile;                       ///< Handle for the opened source file
-extern int   lineNr;                          ///< Current line number in source file
-extern int   column;                          ///< Current column number in source file
-extern char  sl[MAX_LINE_LENGTH];             ///< Current source line buffer
-extern int   prgType;                         ///< Program type (e.g., module, program, etc.)
-extern char  token[MAX_WORD_LENGTH];          ///< Current token string
-extern char  tokenSave[MAX_WORD_LENGTH];      ///< Backup of last token
-extern char  dataSegmentBase[8];
-extern char        baseRegData[5];
-extern char        currentSegment[50];             ///< actual code segment name
-extern int   tokTyp;                          ///< Current token type
-extern int   tokTypSave;                      ///< Backup of token type
-extern int   numToken;                        ///< Number of tokens parsed
-extern int   mode;                            ///< Current parsing mode
-extern int64_t value;                         ///< Numeric value of current token
-extern int   align_val;                       ///< Alignment value for directives
-extern bool  lineERR;                         ///< Error status of current line
-extern bool        sourceERR;                      ///< Flag: true if the source has an error.
-extern int   numOfInstructions;
-extern int   numOfData;
-extern bool  addInstrGlob;
-extern bool  addInstrLine;
-extern char  label[MAX_WORD_LENGTH];          ///< Current label name
-extern char  labelCodeOld[MAX_WORD_LENGTH];
-extern char  labelDataOld[MAX_WORD_LENGTH];
-extern char  currentCODE[MAX_WORD_LENGTH];
-extern int   ind;                             ///< Generic index helper
-extern int   j;                               ///< Generic counter helper
-extern char  errmsg[MAX_ERROR_LENGTH];        ///< Last error message
-extern char  infmsg[MAX_ERROR_LENGTH];        ///< Informational message buffer
-extern bool  is_label;                        ///< Flag: current line contains a label
-extern bool  is_instruction;                  ///< Flag: current line contains an instruction
-extern bool  is_directive;                    ///< Flag: current line contains a directive
-extern bool  is_negative;                     ///< Flag: current token is negative
-extern char  opCode[MAX_WORD_LENGTH];         ///< Current operation mnemonic
-extern int   opInstrType;                     ///< Type of current instruction
-extern int   operandType;                     ///< Type of current operand
-extern int   operandTyp[MAX_WORD_LENGTH];                  ///< Operand type list
-extern int   directiveType;                   ///< Type of current directive
-extern char  dirCode[MAX_WORD_LENGTH];        ///< Directive code string
-extern int   varType;                         ///< Variable type
-extern char  varName[MAX_WORD_LENGTH];        ///< Variable name
-extern char  buffer[255];                     ///< General-purpose buffer
-extern int AST_numInstr;
-extern bool  codeInstrFlag;                   ///< Flag if .CODE or instruction was read in AST
-extern int   nodeTypeOld;
-
-extern bool  codeExist;                       ///< flag if a .CODE directive is present before first instruction    
-extern bool  dataExist;                       ///< flag if a .DATA directive is present before first definitin of byte,half,word etc. 
-extern int   numSegment;
-
-
-extern int   binInstr;                        ///< Current binary instruction word
-extern int   binInstrSave;                    ///< Saved binary instruction word
-extern char  opt1[MAX_WORD_LENGTH];           ///< First instruction option
-extern char  opt2[MAX_WORD_LENGTH];           ///< Second instruction option
-
-extern uint32_t   codeAdr;                         ///< Current code address
-extern uint32_t   dataAdr;                         ///< Current data address
+extern thread_local char  SourceFileName[MAX_FILE_NAME_LENGTH];             ///< Name of the input source file
+extern thread_local char* srcBuf;                          ///< Mapped (or loaded) source file contents
+extern thread_local size_t srcLen;                         ///< Length of the source file in bytes
+extern thread_local bool  srcMapped;                       ///< Flag: srcBuf is a memory mapping
+extern thread_local int   lineNr;                          ///< Current line number in source file
+extern thread_local int   column;             ///< Current column number in source file
+extern thread_local const char* sl;           ///< Current source line (view into srcBuf)
+extern thread_local int   prgType;                         ///< Program type (e.g., module, program, etc.)
+extern thread_local char  token[MAX_WORD_LENGTH];          ///< Current token string
+extern thread_local char  tokenSave[MAX_WORD_LENGTH];      ///< Backup of last token
+extern thread_local const char* tokText;      ///< Text of the token produced by createToken()
+extern thread_local int   tokLen;             ///< Length of tokText
+extern thread_local uint32_t tokId;           ///< Interned name ID of the current identifier token
+extern thread_local char  dataSegmentBase[8];
+extern thread_local char        baseRegData[5];
+extern thread_local char        currentSegment[50];             ///< actual code segment name
+extern thread_local int   tokTyp;             ///< Current token type
+extern thread_local int   tokTypSave;                      ///< Backup of token type
+extern thread_local int64_t numToken;         ///< Value of the current number token
+extern thread_local int   mode;                            ///< Current parsing mode
+extern thread_local int64_t value;                         ///< Numeric value of current token
+extern thread_local int   align_val;                       ///< Alignment value for directives
+extern thread_local bool  lineERR;                         ///< Error status of current line
+extern thread_local bool        sourceERR;                      ///< Flag: true if the source has an error.
+extern thread_local void (*errorSink)(const char* msg);    ///< Collects errors instead of the SRC tree (code generation jobs).
+extern thread_local int   numOfInstructions;
+extern thread_local int   numOfData;
+extern thread_local bool  addInstrGlob;
+extern thread_local bool  addInstrLine;
+extern thread_local char  label[MAX_WORD_LENGTH];          ///< Current label name
+extern thread_local char  labelCodeOld[MAX_WORD_LENGTH];
+extern thread_local char  labelDataOld[MAX_WORD_LENGTH];
+extern thread_local char  currentCODE[MAX_WORD_LENGTH];
+extern thread_local uint32_t currentCODEId;                ///< Interned currentCODE
+extern thread_local int   ind;                ///< Generic index helper
+extern thread_local int   j;                               ///< Generic counter helper
+extern thread_local char  errmsg[MAX_ERROR_LENGTH];        ///< Last error message
+extern thread_local char  infmsg[MAX_ERROR_LENGTH];        ///< Informational message buffer
+extern thread_local bool  is_label;                        ///< Flag: current line contains a label
+extern thread_local bool  is_instruction;                  ///< Flag: current line contains an instruction
+extern thread_local bool  is_directive;                    ///< Flag: current line contains a directive
+extern thread_local bool  is_negative;                     ///< Flag: current token is negative
+extern thread_local char  opCode[MAX_WORD_LENGTH];         ///< Current operation mnemonic
+extern thread_local int   opInstrType;                     ///< Type of current instruction
+extern thread_local int   operandType;                     ///< Type of current operand
+extern thread_local int   operandTyp[MAX_WORD_LENGTH];                  ///< Operand type list
+extern thread_local int   directiveType;                   ///< Type of current directive
+extern thread_local char  dirCode[MAX_WORD_LENGTH];        ///< Directive code string
+extern thread_local int   varType;                         ///< Variable type
+extern thread_local char  varName[MAX_WORD_LENGTH];        ///< Variable name
+extern thread_local char  buffer[255];                     ///< General-purpose buffer
+
+extern thread_local bool  codeExist;                       ///< flag if a .CODE directive is present before first instruction    
+extern thread_local bool  dataExist;                       ///< flag if a .DATA directive is present before first definitin of byte,half,word etc. 
+extern thread_local int   numSegment;
+
+
+extern thread_local int   binInstr;                        ///< Current binary instruction word
+extern thread_local int   binInstrSave;                    ///< Saved binary instruction word
+extern thread_local char  opt1[MAX_WORD_LENGTH];           ///< First instruction option
+extern thread_local char  opt2[MAX_WORD_LENGTH];           ///< Second instruction option
+
+extern thread_local uint32_t   codeAdr;                         ///< Current code address
+extern thread_local uint32_t   dataAdr;                         ///< Current data address
 
 using namespace ELFIO;
-extern section* text_sec;                     ///< ELF .text section
-extern segment* text_seg;                     ///< ELF .text segment
-extern section* data_sec;                     ///< ELF .data section
-extern segment* data_seg;                     ///< ELF .data segment
-extern section* note_sec;                     ///< ELF .note section
-
-extern uint32_t elfCodeAddr;                  ///< ELF code section base address
-extern uint32_t elfCodeAddrOld;
-extern uint32_t elfDataAddr;                  ///< ELF data section base address
-extern uint32_t elfDataAddrOld;
-extern uint32_t elfEntryPoint;                ///< ELF entry point address
-extern bool     elfEntryPointStatus;          ///< Status: entry point defined
-extern uint32_t elfCodeAlign;                 ///< Code section alignment
-extern uint32_t elfDataAlign;                 ///< Data section alignment
-
-extern char     elfData[MAX_WORD_LENGTH];     ///< ELF data section identifier
-extern char     elfCode[MAX_WORD_LENGTH];     ///< ELF code section identifier
-extern int      elfDataLength;                ///< ELF data section length
-extern bool     elfDataSectionStatus;         ///< Flag: ELF data section defined
-extern bool     elfCodeSectionStatus;         ///< Flag: ELF code section defined
-extern char* elfBuffer;                    ///< ELF write buffer
-extern int      elfBufferSize;                ///< ELF buffer size
-
-extern char     func_entry[MAX_WORD_LENGTH];  ///< Function entry symbol
-extern bool     main_func_detected;           ///< Flag: main() detected
-extern char     opchar[5][MAX_WORD_LENGTH];                ///< Operator characters
-extern int      opnum[5];                     ///< Operator numbers
-extern char     option[2][MAX_WORD_LENGTH];                ///< Instruction options
-extern int      opCount;                      ///< Operand count
-extern int      optCount;                     ///< Option count
-extern int      bin_status;                   ///< Binary generation status
-
-extern char            symPrint[132];                  ///< printf param for symtab print
+extern thread_local section* text_sec;                     ///< ELF .text section
+extern thread_local segment* text_seg;                     ///< ELF .text segment
+extern thread_local section* data_sec;                     ///< ELF .data section
+extern thread_local segment* data_seg;                     ///< ELF .data segment
+extern thread_local section* note_sec;                     ///< ELF .note section
+
+extern thread_local uint32_t elfCodeAddr;                  ///< ELF code section base address
+extern thread_local uint32_t elfCodeAddrOld;
+extern thread_local uint32_t elfDataAddr;                  ///< ELF data section base address
+extern thread_local uint32_t elfDataAddrOld;
+extern thread_local uint32_t elfEntryPoint;                ///< ELF entry point address
+extern thread_local bool     elfEntryPointStatus;          ///< Status: entry point defined
+extern thread_local uint32_t elfCodeAlign;                 ///< Code section alignment
+extern thread_local uint32_t elfDataAlign;                 ///< Data section alignment
+
+extern thread_local char     elfData[MAX_WORD_LENGTH];     ///< ELF data section identifier
+extern thread_local char     elfCode[MAX_WORD_LENGTH];     ///< ELF code section identifier
+extern thread_local int      elfDataLength;                ///< ELF data section length
+extern thread_local bool     elfCodeSectionStatus;         ///< Flag: ELF code section defined
+
+extern thread_local char     func_entry[MAX_WORD_LENGTH];  ///< Function entry symbol
+extern thread_local bool     main_func_detected;           ///< Flag: main() detected
+extern thread_local const char* opchar[5];                 ///< Operand texts
+extern thread_local int      opnum[5];                     ///< Operator numbers
+extern thread_local uint32_t opId[5];                      ///< Interned operand names
+extern thread_local struct SymNode* opSym[5];              ///< Resolved label operands
+extern thread_local uint32_t instrCodeAdr;                 ///< Parse-time address of the instruction being encoded
+extern thread_local uint32_t instrSectionId;               ///< Code section of the instruction being encoded
+extern thread_local const char* opBaseReg;                 ///< Base register of the instruction being encoded
+extern thread_local const char* option[2];                 ///< Instruction options
+extern thread_local int      opCount;                      ///< Operand count
+extern thread_local int      optCount;                     ///< Option count
+extern thread_local int      bin_status;                   ///< Binary generation status
+
+extern thread_local char            symPrint[132];                  ///< printf param for symtab print
 
 
 
@@ -119,60 +125,64 @@ extern char            symPrint[132];                  ///< printf param for sym
 // Symbol Table Globals
 // ============================================================================
 
-extern struct SymNode* scopeTab[10];          ///< Scope stack
-extern char            scopeNameTab[50][10];  ///< Names of scopes
-extern int             currentScopeLevel;     ///< Current scope nesting level
-extern int             searchScopeLevel;      ///< Scope level for search
-extern int             maxScopeLevel;         ///< Maximum scope level
-extern char            currentScopeName[50];  ///< Current scope name
-extern char            currentScopeNameSave[50]; ///< Saved scope name
-extern SYM_ScopeType   currentScopeType;      ///< Current scope type
-extern bool            symFound;              ///< Symbol search status
-extern struct SymNode* GlobalSYM;             ///< Global symbol table root
-extern struct SymNode* program;               ///< Program symbol node
-extern struct SymNode* module;                ///< Module symbol node
-extern struct SymNode* function;              ///< Function symbol node
-extern struct SymNode* block;                 ///< Block symbol node
-extern struct SymNode* directive;             ///< Directive symbol node
-extern SymNode* currentSym;            ///< Current symbol
-extern SymNode* currentSymSave;        ///< Saved current symbol
-extern char            symFunc[50];           ///< Function name of symbol
-extern char            symValue[50];          ///< Value of symbol
-extern char            symDataSegmentBase[5];
-extern int64_t         symcodeAdr;            ///< Code address of symbol
+extern thread_local struct SymNode* scopeTab[10];          ///< Scope stack
+extern thread_local char            scopeNameTab[50][10];  ///< Names of scopes
+extern thread_local int             currentScopeLevel;     ///< Current scope nesting level
+extern thread_local int             searchScopeLevel;      ///< Scope level for search
+extern thread_local int             maxScopeLevel;         ///< Maximum scope level
+extern thread_local char            currentScopeName[50];  ///< Current scope name
+extern thread_local uint32_t        currentScopeId;        ///< Interned current scope name (codegen)
+extern thread_local char            currentScopeNameSave[50]; ///< Saved scope name
+extern thread_local SYM_ScopeType   currentScopeType;      ///< Current scope type
+extern thread_local bool            symFound;              ///< Symbol search status
+extern thread_local struct SymNode* GlobalSYM;             ///< Global symbol table root
+extern thread_local struct SymNode* program;               ///< Program symbol node
+extern thread_local struct SymNode* module;                ///< Module symbol node
+extern thread_local struct SymNode* function;              ///< Function symbol node
+extern thread_local struct SymNode* block;                 ///< Block symbol node
+extern thread_local struct SymNode* directive;             ///< Directive symbol node
+extern thread_local SymNode* currentSym;            ///< Current symbol
+extern thread_local char            symFunc[50];           ///< Function name of symbol
+extern thread_local char            symValue[50];          ///< Value of symbol
+extern thread_local int64_t         symNumValue;           ///< Evaluated value of symbol (EQU)
+extern thread_local char            symDataSegmentBase[5];
+extern thread_local int64_t         symcodeAdr;            ///< Code address of symbol
 
 // ============================================================================
 // AST Globals
 // ============================================================================
 
-extern struct ASTNode* ASTprogram;            ///< Root node of AST
-extern struct ASTNode* ASTinstruction;        ///< Current AST instruction node
-extern struct ASTNode* ASTdirective;
-extern struct ASTNode* ASTcode;
-extern struct ASTNode* ASToperation;          ///< AST operation node
-extern struct ASTNode* ASTop1;                ///< AST operand 1
-extern struct ASTNode* ASTop2;                ///< AST operand 2
-extern struct ASTNode* ASTop3;                ///< AST operand 3
-extern struct ASTNode* ASTop4;                ///< AST operand 4
-extern struct ASTNode* ASTlabel;              ///< AST label node
-extern struct ASTNode* ASTmode;               ///< AST mode node
-extern struct ASTNode* ASTopt1;               ///< AST option 1
-extern struct ASTNode* ASTopt2;               ///< AST option 2
-extern struct ASTNode* ASTaddr;               ///< AST addr
-extern struct ASTNode* ASTalign;              ///< AST align
-extern struct ASTNode* ASTentry;              ///< AST entry
+extern thread_local struct ASTNode* ASTprogram;            ///< Root node of AST
+extern thread_local struct ASTNode* ASTinstruction;        ///< Current AST instruction node
+extern thread_local struct ASTNode* ASTdirective;
+extern thread_local struct ASTNode* ASTcode;
+extern thread_local struct ASTNode* ASToperation;          ///< AST operation node
+extern thread_local struct ASTNode* ASTop1;                ///< AST operand 1
+extern thread_local struct ASTNode* ASTop2;                ///< AST operand 2
+extern thread_local struct ASTNode* ASTop3;                ///< AST operand 3
+extern thread_local struct ASTNode* ASTop4;                ///< AST operand 4
+extern thread_local struct ASTNode* ASTlabel;              ///< AST label node
+extern thread_local struct ASTNode* ASTmode;               ///< AST mode node
+extern thread_local struct ASTNode* ASTopt1;               ///< AST option 1
+extern thread_local struct ASTNode* ASTopt2;               ///< AST option 2
+extern thread_local struct ASTNode* ASTaddr;               ///< AST addr
+extern thread_local struct ASTNode* ASTalign;              ///< AST align
+extern thread_local struct ASTNode* ASTentry;              ///< AST entry
 
 // ============================================================================
 // SRC Globals
 // ============================================================================
 
-extern SRC_NodeType    currentSRC_type;       ///< Current SRC node type
-extern struct SRCNode* GlobalSRC;             ///< Root of SRC tree
-extern struct SRCNode* SRCprogram;            ///< SRC program node
-extern struct SRCNode* SRCsource;             ///< SRC source node
-extern struct SRCNode* SRCbin;                ///< SRC binary node
-extern struct SRCNode* SRCerror;              ///< SRC error node
-extern struct SRCNode* SRCcurrent;            ///< Current SRC node
+extern thread_local SRC_NodeType    currentSRC_type;       ///< Current SRC node type
+extern thread_local struct SRCNode* GlobalSRC;             ///< Root of SRC tree
+extern thread_local struct SRCNode* SRCprogram;            ///< SRC program node
+extern thread_local struct SRCNode* SRCsource;             ///< SRC source node
+extern thread_local struct SRCNode* SRCbin;                ///< SRC binary node
+extern thread_local struct SRCNode* SRCerror;              ///< SRC error node
+extern thread_local struct SRCNode* SRCcurrent;            ///< Current SRC node
+extern thread_local struct SRCNode* srcLineTab;            ///< Source line records, indexed by line number - 1
+extern thread_local int srcLineCount;                      ///< Number of source line records
+extern thread_local int srcLineCapacity;                   ///< Allocated entries in srcLineTab
 
 // ============================================================================
 // Debug Flags
@@ -183,80 +193,159 @@ extern bool DBG_PARSER;  ///< Enable parser debug output
 extern bool DBG_GENBIN;  ///< Enable binary generation debug output
 extern bool DBG_SYMTAB;  ///< Enable symbol table debug output
 extern bool DBG_AST;     ///< Enable AST debug output
+extern bool DBG_ELF;     ///< Enable ELF dump
+extern int DBG_ELF_PARTS;           ///< Parts of the ELF dump (ELF_DUMP_ flags)
+extern const char* DBG_ELF_SECTION; ///< Section whose contents are dumped (NULL: all)
+extern int DBG_ELF_BYTES;           ///< Bytes dumped per section at most (0: no limit)
 
 // ============================================================================
 // Data Structures
 // ============================================================================
 
-/// \brief Token list (linked list of scanned tokens).
-struct tokenList {
-    int t_lineNr;                      ///< Source line number
+/// \brief Bump allocator for nodes that live for one assembler phase.
+/// \details
+/// Memory is carved from a list of chunks and is only given back as a
+/// whole by arenaRelease(); single objects are never freed.
+struct arena {
+    struct arenaChunk* ar_chunk;  ///< Current chunk (chunks are linked backwards)
+    size_t ar_used;               ///< Bytes used in the current chunk
+    size_t ar_size;               ///< Usable bytes of the current chunk
+};
+extern thread_local struct arena astArena;          ///< AST nodes and child spans (released after codegen)
+extern thread_local struct arena symArena;          ///< Symbol nodes and child spans
+extern thread_local struct arena srcArena;          ///< SRC nodes, messages and child spans
+
+struct interner;
+extern thread_local struct interner* internTab;     ///< Interned names of the assembly (see internName())
+
+/// \brief Thrown by fatalError() to abandon the current assembly.
+struct assemblyAbort {};
+
+/// \brief Token stream entry (contiguous array of scanned tokens).
+struct tokenEntry {
+    const char* t_text;                    ///< Token text (view into srcBuf or rewritten copy)
+    int t_lineNr;                          ///< Source line number
     int t_column;                          ///< Source column number
-    int t_tokTyp;                          ///< Token type
-    char t_token[MAX_WORD_LENGTH];         ///< Token value (as string)
-    struct tokenList* next;              ///< Pointer to next token
+    uint16_t t_length;                     ///< Length of the token text
+    int16_t t_tokTyp;                      ///< Token type
+    uint32_t t_id;                         ///< Interned upper-case name (identifiers only, else 0)
+    int64_t t_value;                       ///< Evaluated value (numbers only, else 0)
+};
+extern thread_local struct tokenEntry* tokenTab;      ///< Token stream
+extern thread_local int tokenCount;                   ///< Number of tokens in tokenTab
+extern thread_local int tokenCapacity;                ///< Allocated entries in tokenTab
+extern thread_local int tokenIndex;                   ///< Index of the current token
+extern thread_local struct tokenEntry* ptr_t;         ///< Current token (getToken(tokenIndex))
+extern bool streamMode;                  ///< Lexer streams tokens to the parser (-s)
+extern int  codegenThreads;              ///< Code generation threads (-j), 0: automatic
+
+/// \brief Instruction word written by an ADDIL expansion (B_BINCHILD).
+struct BINNote {
+    int n_index;                  ///< Index of the word in b_code
+    bool n_addil;                 ///< TRUE: the inserted ADDIL, FALSE: the instruction it serves
+    const char* n_infotext;       ///< Info text for the listing (in srcArena)
 };
-extern struct tokenList* next_t;         ///< Next token pointer
-extern struct tokenList* start_t;        ///< Start of token list
-extern struct tokenList* ptr_t;          ///< General token pointer
-
-/// \brief Binary and linked list.
-struct BINList {
-    int b_type;                   ///< Node type 1=instruction 2=Code
-    int b_lineNr;                 ///< Source line number
-    // instruction part
-    int b_codeAdr;                ///< Code address
-    uint32_t b_binInstr;          ///< Binary instruction
-    int b_bin_status;             ///< 1=exist instruction 2=add instruction
-    // code part
-    char b_name[MAX_WORD_LENGTH];              ///< name of code section
-    char b_infotext[MAX_LINE_LENGTH];
+
+/// \brief Binary code of one code section.
+/// \details
+/// The instruction words are kept in address order, 4 bytes each. The source
+/// line of a word follows from the instruction records (one word per record
+/// plus the inserted ADDILs); the rare ADDIL expansions are described by the
+/// notes.
+struct BINSection {
+    bool b_header;                ///< Section starts with a .CODE directive (else: code in front of the first one)
+    int b_lineNr;                 ///< Source line of the .CODE directive
+    uint32_t b_nameId;            ///< Interned name of code section
     int b_addr;                   ///< param addr of code
-    int b_numOfInstructions;      ///< number of instructions
-    int b_entry;                 ///<  param entry
-    struct BINList* next;       ///< next pointer
+    int b_codeAdr;                ///< Code address in front of the first word
+    int b_firstRecord;            ///< First instruction record (index in instrTab)
+    uint32_t* b_code;             ///< Instruction words
+    int b_count;                  ///< Number of words in b_code
+    int b_capacity;               ///< Allocated words in b_code
+    struct BINNote* b_notes;      ///< ADDIL expansions, ordered by n_index
+    int b_noteCount;              ///< Number of entries in b_notes
+    int b_noteCapacity;           ///< Allocated entries in b_notes
 };
-extern struct BINList* next_b;         ///< Next BIN pointer
-extern struct BINList* start_b;        ///< Start of BIN list
-extern struct BINList* ptr_b;          ///< General BIN pointer
+extern thread_local struct BINSection* binTab;      ///< Code sections in source order
+extern thread_local int binCount;                   ///< Number of sections in binTab
+extern thread_local int binCapacity;                ///< Allocated entries in binTab
 
 /// \brief Symbol table node.
+/// \details
+/// Names are interned IDs (see internText() for the text); the value text
+/// lives in ::symArena, so that a symbol fits in a single cache line.
 struct SymNode {
-    SYM_ScopeType y_type;         ///< Scope type
-    int y_scopeLevel;             ///< Scope nesting level
-    char y_scopeName[MAX_WORD_LENGTH];         ///< Scope name
-    char y_baseReg[MAX_WORD_LENGTH]; ///< base register for segment
-    char y_label[MAX_WORD_LENGTH];             ///< Symbol label
-    char y_func[MAX_WORD_LENGTH];              ///< Function name
-    char y_value[MAX_LINE_LENGTH];             ///< Symbol value
-    int y_varType;                ///< Variable type
+    uint8_t y_type;               ///< Scope type (SYM_ScopeType)
+    uint8_t y_scopeLevel;         ///< Scope nesting level
+    uint16_t y_varType;           ///< Variable type
+    uint32_t y_labelId;           ///< Interned symbol label
+    uint32_t y_scopeId;           ///< Interned scope name
+    uint32_t y_funcId;            ///< Interned function name
+    uint32_t y_codeSectionId;     ///< Interned current Codesection name
     int y_lineNr;                 ///< Source line number
     uint32_t y_codeAdr;                ///< Code address
     uint32_t y_dataAdr;                ///< Data address
-    char y_currCodeSection[MAX_WORD_LENGTH];       ///< current Codesection name
-    struct SymNode** children;  ///< Child symbols
     int y_childCount;             ///< Number of children
+    uint32_t y_baseRegId;         ///< Interned base register for segment (R0..R15)
+    int64_t y_value;              ///< Evaluated value (EQU), else 0
+    const char* y_valueText;      ///< Symbol value text (in ::symArena)
+    struct SymNode** children;  ///< Child symbols
 };
+static_assert(sizeof(struct SymNode) <= 64, "SymNode exceeds a cache line");
 
 /// \brief Abstract Syntax Tree (AST) node.
 struct ASTNode {
     AST_NodeType a_type;          ///< Node type
-    char* a_value;                ///< String value
+    const char* a_value;          ///< String value (in ::astArena)
     int32_t a_valnum;                 ///< Numeric value
     int a_lineNr;                 ///< Source line number
     int a_column;                 ///< Source column number
     int a_scopeLevel;             ///< Scope nesting level
-    char* a_scopeName;            ///< Scope name
-    int a_numInstr;           ///< indicator number of instructiions per source line
+    const char* a_scopeName;      ///< Scope name
+    uint32_t a_valueId;           ///< Interned value if it is an identifier, else 0
+    uint32_t a_scopeId;           ///< Interned scope name
+    uint32_t a_codeSectionId;     ///< Interned code section name
     uint32_t a_codeAdr;                ///< Code address
     int a_operandType;            ///< Operand type (1=REGISTER, 2=MEMORY, 3=LABEL)
-    char* a_baseReg;              ///< base register for variable
+    const char* a_baseReg;        ///< base register for variable
     uint32_t a_binInstr;         ///< Encoded instruction word
     SymNode* symNodeAdr;        ///< Linked symbol table node
+    SymNode* a_symbol;            ///< Resolved label of an OT_LABEL operand, else NULL
     struct ASTNode** children;  ///< Child nodes
     int a_childCount;             ///< Number of children
 };
 
+/// \brief Flat record of one instruction or `.CODE` directive for codegen.
+/// \details
+/// The parser appends a record whenever it adds an instruction or code
+/// section node to the AST and fills it in as the children are added, so
+/// codegen is a plain loop over ::instrTab. Labels and sections are interned
+/// IDs; operand and option texts point into ::astArena.
+struct instrRecord {
+    uint8_t r_kind;               ///< NODE_INSTRUCTION or NODE_CODE
+    uint8_t r_opCount;            ///< Number of operands
+    uint8_t r_optCount;           ///< Number of options
+    uint8_t r_flags;              ///< NODE_CODE: CODE_* attributes present
+    int r_lineNr;                 ///< Source line number
+    int r_instrType;              ///< Operation type (opCodeTab[].instrType)
+    int r_mode;                   ///< Addressing mode
+    uint32_t r_binInstr;          ///< Opcode bits
+    uint32_t r_codeAdr;           ///< Parse-time code address
+    uint32_t r_addr;              ///< NODE_CODE: ADDR value
+    uint32_t r_align;             ///< NODE_CODE: ALIGN value
+    uint32_t r_sectionId;         ///< Interned code section name
+    uint32_t r_labelId;           ///< Interned label of the line, else 0
+    const char* r_baseReg;        ///< Base register of the last operand
+    SymNode* r_label;             ///< Resolved label operand, else NULL
+    const char* r_opt[MAX_INSTR_OPTIONS];  ///< Option texts
+    const char* r_op[MAX_INSTR_OPERANDS];  ///< Operand texts
+    uint32_t r_opId[MAX_INSTR_OPERANDS];   ///< Interned operand identifiers, else 0
+    int32_t r_opNum[MAX_INSTR_OPERANDS];   ///< Numeric operand values
+    uint8_t r_opType[MAX_INSTR_OPERANDS];  ///< Operand types (OT_*)
+};
+extern thread_local struct instrRecord* instrTab;   ///< Instruction records in source order
+extern thread_local int instrCount;                 ///< Number of instruction records
+
 /// \brief Source representation node (text, error, binary).
 struct SRCNode {
     SRC_NodeType s_type;          ///< Node type
@@ -264,7 +353,9 @@ struct SRCNode {
     uint32_t s_codeAdr;                ///< Code address
     uint32_t s_binInstr;          ///< Binary instruction
     int s_binStatus;              ///< Binary status (0=none, 1=exists, 2=in child)
-    char* s_text;                 ///< Associated text
+    char* s_text;                 ///< Associated text (NULL for source lines)
+    int s_textLen;                ///< Length of the text (source lines: without '\n')
+    size_t s_offset;              ///< Source lines: offset of the text in srcBuf
     int s_scopeLevel;             ///< Scope nesting level
     struct SRCNode** children;  ///< Child nodes
     int s_childCount;             ///< Number of children
@@ -281,18 +372,21 @@ typedef struct {
 } SegmentTableEntry;
 
 
-extern SegmentTableEntry table[MAX_ENTRIES];
+extern thread_local SegmentTableEntry table[MAX_ENTRIES];
 
 // ============================================================================
 // Function Prototypes
 // ============================================================================
 
 // -- ASM32.cpp
+int assembleFile(const char* fileName);
 SRCNode* createSRCnode(SRC_NodeType type, const char* text, int lineNr);
+SRCNode* createSRCline(size_t offset, int len, int lineNr);
 void addSRCchild(SRCNode* parent, SRCNode* child);
 void printSourceListing(SRCNode* node, int depth);
-void searchSRC(SRCNode* node, int depth);
-void insertBinToSRC(SRCNode* node, int depth);
+SRCNode* findSRCline(int lineNr);
+void searchSRC();
+void insertBinToSRC();
 void setDefaultDirectives();
 int addSegmentEntry(int index, const char* name, char type, int addr, int len);
 int compareByAddr(const void* a, const void* b);
@@ -301,6 +395,11 @@ void printSegmentTable(int count);
 // -- utils.cpp
 void openSourceFile();
 void closeSourceFile();
+void* arenaAlloc(struct arena* a, size_t size);
+char* arenaText(struct arena* a, const char* text);
+void* arenaSpan(struct arena* a, void* span, int count, size_t elemSize);
+void arenaAdopt(struct arena* dst, struct arena* src);
+void arenaRelease(struct arena* a);
 void extract_path(const char* fullpath, char* path_out, size_t out_size);
 void changeExtension2Out(const char* input, char* output, size_t out_size);
 void fatalError(const char* msg);
@@ -311,9 +410,23 @@ void processInfo(const char* msg);
 void printDebug(const char* msg);
 void strToUpper(char* _str);
 int  strToNum(char* _str);
+struct interner* createInterner();
+void releaseInterner(struct interner* t);
+uint32_t internName(const char* text, int len);
+uint32_t internString(const char* text);
+uint32_t findName(const char* text);
+const char* internText(uint32_t id);
 
 // -- lexer.cpp
+void initScanner();
+void lexSourceFile();
+void startTokenStream();
+void finishTokenStream();
+void releaseLexer();
+bool hasToken(int index);
+struct tokenEntry* getToken(int index);
 void createTokenEntry();
+void getTokenText(struct tokenEntry* t, char* dst);
 void printTokenList();
 void createToken();
 
@@ -335,40 +448,48 @@ void    addScope(SYM_ScopeType type, char* label, char* func, const char* value,
 void    addSYMchild(SymNode* parent, SymNode* child);
 SymNode* createSYMnode(SYM_ScopeType type, char* label, char* func, const char* value, int linenr);
 void    printSYM(SymNode* node, int depth);
-void    searchSymAll(SymNode* node, char* label, int depth);
-void    searchSymLevel(SymNode* node, char* label, int depth);
+void    addSYMhash(SymNode* node);
+void    addLabelRef(ASTNode* node);
+void    resolveLabelRefs();
+void    searchSymAll(const char* label);
+void    searchSymLevel(const char* label);
+void    searchSymLevelId(uint32_t labelId, uint32_t scopeId);
 bool    searchSymbol(SymNode* node, char* label);
 ASTNode* createASTnode(AST_NodeType type, const char* value, int valnum);
 void    addASTchild(ASTNode* parent, ASTNode* child);
 void    printAST(ASTNode* node, int depth);
-void    updSYM(SymNode* node, int depth);
+void    addCodeShift(uint32_t sectionId, uint32_t codeAdr);
+uint32_t getSymCodeAdr(SymNode* node);
+void    releaseParser();
 
 // -- codegen.cpp
-void clrBit(int pos);
 void createBinary();
 void genBinInstruction();
+void resolveBranchFixups();
 void genBinOption();
-int  getSegRegister(char* regname);
-void processAST(ASTNode* node, int depth);
-void setBit(int pos, int32_t x, int num);
-void setGenRegister(int reg, char* regname);
-void setMRRegister(char* regname);
-void setDataOffset(int pos, int x, int num);
-void createBINEntry();
+int  getSegRegister(const char* regname);
+void processInstructions();
+void setGenRegister(int reg, const char* regname);
+void setMRRegister(const char* regname);
 void processBIN();
 void deleteBIN();
+void releaseCodegen();
 
 // -- ELF writer
 int createELF();
 int createTextSection(char* name);
 int addTextSectionData();
+int addTextSectionCode(const uint32_t* code, int count);
 int createTextSegment();
 int addTextSectionToSegment();
 int createDataSection(char* name);
-int addDataSectionData(char* data, int len);
+int addDataSectionData(const char* data, int len);
+int addDataSectionFill(int value, int len);
 int createDataSegment();
 int addDataSectionToSegment();
 int addNote();
 int writeElfFile(char* file);
+void dumpElf(int parts, const char* sectionName, int maxBytes);
+void releaseELF();
 
 #endif
@@ -1,6 +1,18 @@
 #include "constants.hpp"
 #include "ASM32.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <elfio/elfio_dump.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 /// @file
 /// \brief ELF output module for the ASM32 assembler.
 /// \details
@@ -9,15 +21,179 @@
 /// and segments, and provides helper functions to build the `.text`
 /// and `.data` sections, insert machine code and data, and write
 /// the final ELF executable.  
+///
+/// elfio holds the headers, names and notes of the file, but not the
+/// contents of the code and data sections. Those are recorded as spans
+/// (::ELFSpan): the instruction words of a code section stay in their
+/// BIN section and are converted to big-endian when the file is written,
+/// the values and padding of a data section are collected in ::dataSpan,
+/// which the span takes over when the section is complete.
+/// ::writeElfFile computes the file layout itself, sizes the output file
+/// and maps it, and stores headers and spans straight into the mapping,
+/// so no second copy of the image is built.
+///
+/// Zero bytes at the end of a data section are only counted
+/// (::dataZeros). They end up in an `SHT_NOBITS` section, which occupies
+/// memory but no file space: the data section itself if it holds nothing
+/// else, or a `.bss.` section placed behind it in the same segment.
 
 using namespace ELFIO;
 
-elfio writer;                  ///< ELF writer instance.
-section* text_sec = nullptr;   ///< Pointer to the .text section.
-segment* text_seg = nullptr;   ///< Pointer to the program segment containing .text.
-section* data_sec = nullptr;   ///< Pointer to the .data section.
-segment* data_seg = nullptr;   ///< Pointer to the program segment containing .data.
-section* note_sec = nullptr;   ///< Pointer to the .note section.
+thread_local elfio writer;                  ///< ELF writer instance.
+thread_local section* text_sec = nullptr;   ///< Pointer to the .text section.
+thread_local segment* text_seg = nullptr;   ///< Pointer to the program segment containing .text.
+thread_local section* data_sec = nullptr;   ///< Pointer to the .data section.
+thread_local segment* data_seg = nullptr;   ///< Pointer to the program segment containing .data.
+thread_local section* note_sec = nullptr;   ///< Pointer to the .note section.
+
+static thread_local char* dataSpan = NULL;          ///< Bytes of the current .data section not yet in data_sec.
+static thread_local size_t dataSpanLen = 0;         ///< Number of bytes in dataSpan.
+static thread_local size_t dataSpanCapacity = 0;    ///< Allocated bytes in dataSpan.
+static thread_local size_t dataZeros = 0;           ///< Zero bytes following dataSpan, not stored.
+
+/// \brief Part of the contents of a section, written by ::writeElfFile.
+struct ELFSpan {
+    section*        e_section;  ///< Section the span belongs to.
+    Elf_Xword       e_offset;   ///< Offset of the span within the section.
+    Elf_Xword       e_len;      ///< Length in bytes.
+    const char*     e_bytes;    ///< Bytes, or NULL for instruction words.
+    const uint32_t* e_words;    ///< Instruction words (host order), if e_bytes is NULL.
+    bool            e_owned;    ///< e_bytes is freed with the span table.
+};
+
+static thread_local struct ELFSpan* spanTab = NULL;  ///< Section spans in the order they were added.
+static thread_local int spanCount = 0;               ///< Number of spans in spanTab.
+static thread_local int spanCapacity = 0;            ///< Allocated entries in spanTab.
+
+
+// --------------------------------------------------------------------------------
+//  Section Spans
+// --------------------------------------------------------------------------------
+
+/// \brief Store instruction words in big-endian byte order.
+/// \param dst   Destination, 4 * count bytes (no alignment required).
+/// \param src   Instruction words.
+/// \param count Number of words.
+/// \details
+/// With SSE2 four words are swapped at a time: the bytes of each 16-bit
+/// half are exchanged by shifts, then the halves by a shuffle.
+static void storeBigEndian32(char* dst, const uint32_t* src, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*)(dst + 4 * i), x);
+    }
+#endif
+    for (; i < count; i++) {
+        dst[4 * i] = (src[i] >> 24) & 0xFF;
+        dst[4 * i + 1] = (src[i] >> 16) & 0xFF;
+        dst[4 * i + 2] = (src[i] >> 8) & 0xFF;
+        dst[4 * i + 3] = src[i] & 0xFF;
+    }
+}
+
+/// \brief Add a span to the contents of a section.
+/// \param sec   Section.
+/// \param bytes Bytes, or NULL if the span holds instruction words.
+/// \param words Instruction words, used if bytes is NULL.
+/// \param len   Length in bytes.
+/// \param owned TRUE if bytes is a heap buffer the span takes over.
+/// \details
+/// Only the section size is recorded in elfio; the contents stay where
+/// they are until the file is written.
+static void addSectionSpan(section* sec, const char* bytes, const uint32_t* words, size_t len, bool owned) {
+    if (spanCount == spanCapacity) {
+        spanCapacity = (spanCapacity == 0) ? 64 : spanCapacity * 2;
+        spanTab = (struct ELFSpan*)realloc(spanTab, sizeof(struct ELFSpan) * spanCapacity);
+        if (spanTab == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    struct ELFSpan* e = &spanTab[spanCount++];
+    e->e_section = sec;
+    e->e_offset = sec->get_size();
+    e->e_len = len;
+    e->e_bytes = bytes;
+    e->e_words = words;
+    e->e_owned = owned;
+    sec->set_size(e->e_offset + len);
+}
+
+/// \brief Make room for len more bytes in ::dataSpan.
+static void growDataSpan(size_t len) {
+    if (dataSpanLen + len > dataSpanCapacity) {
+        while (dataSpanLen + len > dataSpanCapacity) {
+            dataSpanCapacity = (dataSpanCapacity == 0) ? 4096 : dataSpanCapacity * 2;
+        }
+        dataSpan = (char*)realloc(dataSpan, dataSpanCapacity);
+        if (dataSpan == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+}
+
+/// \brief Store the counted zero bytes, non-zero data follows them.
+static void storeDataZeros() {
+    if (dataZeros > 0) {
+        growDataSpan(dataZeros);
+        memset(dataSpan + dataSpanLen, 0, dataZeros);
+        dataSpanLen += dataZeros;
+        dataZeros = 0;
+    }
+}
+
+/// \brief Hand the collected bytes of the current `.data` section to elfio.
+/// \details
+/// Trailing zero bytes become an `SHT_NOBITS` section: the data section
+/// itself if it has no other content, else a `.bss.` section that follows
+/// it in the data segment (the segment's memory size then exceeds its
+/// file size).
+static void flushDataSection() {
+    bool hasData = FALSE;
+    if (dataSpanLen > 0) {
+        addSectionSpan(data_sec, dataSpan, NULL, dataSpanLen, TRUE);
+        dataSpan = NULL;
+        dataSpanLen = 0;
+        dataSpanCapacity = 0;
+        hasData = TRUE;
+    }
+    if (dataZeros > 0) {
+        section* zero_sec = data_sec;
+        if (hasData) {
+            std::string name = data_sec->get_name();
+            name.replace(0, strlen(".data"), ".bss");
+            zero_sec = writer.sections.add(name);
+            zero_sec->set_flags(SHF_ALLOC | SHF_WRITE);
+            zero_sec->set_addr_align(1);
+            data_seg->add_section(zero_sec, zero_sec->get_addr_align());
+        }
+        zero_sec->set_type(SHT_NOBITS);
+        zero_sec->set_size(dataZeros);
+        dataZeros = 0;
+    }
+}
+
+/// \brief Free the ELF staging buffers and section spans of the current assembly.
+void releaseELF() {
+    for (int i = 0; i < spanCount; i++) {
+        if (spanTab[i].e_owned) {
+            free((char*)spanTab[i].e_bytes);
+        }
+    }
+    free(spanTab);
+    spanTab = NULL;
+    spanCount = 0;
+    spanCapacity = 0;
+    free(dataSpan);
+    dataSpan = NULL;
+    dataSpanLen = 0;
+    dataSpanCapacity = 0;
+    dataZeros = 0;
+}
 
 
 // --------------------------------------------------------------------------------
@@ -71,6 +247,18 @@ int addTextSectionData() {
     return 0;
 }
 
+/// \brief Add the instruction words of a code section to the `.text` section.
+/// \param code  Instruction words.
+/// \param count Number of words.
+/// \details
+/// The words are not copied: they must stay valid until the file is
+/// written, which converts them to big-endian on the way out.
+/// \return 0 on success.
+int addTextSectionCode(const uint32_t* code, int count) {
+    addSectionSpan(text_sec, NULL, code, (size_t)count * 4, FALSE);
+    return 0;
+}
+
 /// \brief Create the `.text` segment.
 /// \details
 /// The `.text` segment is loadable and contains the `.text` section.  
@@ -114,15 +302,42 @@ int createDataSection(char* name) {
 /// \brief Add data to the `.data` section.
 /// \param data Pointer to the data buffer.
 /// \param len  Length of the data in bytes.
+/// \details
+/// The bytes are collected in ::dataSpan; the section receives them in one
+/// piece when the next data segment starts or the file is written. Values
+/// that are all zero are only counted.
 /// \return 0 on success.
-int addDataSectionData(char* data, int len) {
-    if (elfDataSectionStatus == FALSE) {
-        data_sec->set_data(data, len);
-        elfDataSectionStatus = TRUE;
+int addDataSectionData(const char* data, int len) {
+    int i = 0;
+    while (i < len && data[i] == 0) {
+        i++;
     }
-    else {
-        data_sec->append_data(data, len);
+    if (i == len) {
+        dataZeros += len;
+        return 0;
     }
+    storeDataZeros();
+    growDataSpan(len);
+    memcpy(dataSpan + dataSpanLen, data, len);
+    dataSpanLen += len;
+    return 0;
+}
+
+/// \brief Fill bytes of the `.data` section with one value.
+/// \param value Byte value.
+/// \param len   Number of bytes.
+/// \details
+/// Used for `.BUFFER` and alignment padding. Zero fills are only counted.
+/// \return 0 on success.
+int addDataSectionFill(int value, int len) {
+    if (value == 0) {
+        dataZeros += len;
+        return 0;
+    }
+    storeDataZeros();
+    growDataSpan(len);
+    memset(dataSpan + dataSpanLen, value, len);
+    dataSpanLen += len;
     return 0;
 }
 
@@ -132,6 +347,7 @@ int addDataSectionData(char* data, int len) {
 /// It is marked as readable and writable.
 /// \return 0 on success.
 int createDataSegment() {
+    flushDataSection();
     data_seg = writer.segments.add();
     data_seg->set_type(PT_LOAD);
     data_seg->set_virtual_address(elfDataAddr);
@@ -173,13 +389,393 @@ int addNote() {
 //  Finalization
 // --------------------------------------------------------------------------------
 
+/// \brief Store a 16-bit value big-endian.
+static void putBE16(char* p, uint32_t v) {
+    p[0] = (v >> 8) & 0xFF;
+    p[1] = v & 0xFF;
+}
+
+/// \brief Store a 32-bit value big-endian.
+static void putBE32(char* p, uint32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+/// \brief Compute the file layout of the ELF image.
+/// \param secOff Receives the file offset of each section.
+/// \param segOff Receives the file offset of each segment.
+/// \details
+/// Follows the layout elfio's save uses for the files built here (load
+/// segments in creation order, no nested segments, section addresses
+/// taken from their segment): the program header table follows the ELF
+/// header, then each segment is placed at an offset congruent to its
+/// address, its sections aligned within it, then the sections without
+/// segment, then the section header table. Sets the segment sizes and
+/// the section addresses.
+/// \return File offset of the section header table.
+static Elf64_Off layoutElf(Elf64_Off* secOff, Elf64_Off* segOff) {
+    int nSeg = writer.segments.size();
+    int nSec = writer.sections.size();
+    Elf64_Off pos = writer.get_header_size() + (Elf64_Off)writer.get_segment_entry_size() * nSeg;
+
+    bool* placed = (bool*)calloc(nSec > 0 ? nSec : 1, sizeof(bool));
+    if (placed == NULL) {
+        fatalError("malloc failed");
+    }
+    for (int i = 0; i < nSeg; i++) {
+        segment* seg = writer.segments[i];
+        int n = seg->get_sections_num();
+
+        // a segment is aligned like its strictest section
+        for (int k = 0; k < n; k++) {
+            section* sec = writer.sections[seg->get_section_index_at(k)];
+            if (sec->get_addr_align() > seg->get_align()) {
+                seg->set_align(sec->get_addr_align());
+            }
+        }
+        if (n > 0) {
+            Elf_Xword align = (seg->get_align() > 0) ? seg->get_align() : 1;
+            Elf64_Off adjust = seg->get_virtual_address() % align - pos % align;
+            pos += (seg->get_align() + adjust) % align;
+        }
+
+        Elf64_Off start = pos;
+        Elf_Xword fileSize = 0;
+        Elf_Xword memSize = 0;
+        for (int k = 0; k < n; k++) {
+            Elf_Half index = seg->get_section_index_at(k);
+            section* sec = writer.sections[index];
+            if (sec->get_type() == SHT_NULL) {
+                placed[index] = TRUE;
+                continue;
+            }
+            Elf_Xword align = (sec->get_addr_align() > 0) ? sec->get_addr_align() : 1;
+            Elf_Xword pad = (align - pos % align) % align;
+            if (sec->get_flags() & SHF_ALLOC) {
+                memSize += sec->get_size() + pad;
+            }
+            if (sec->get_type() != SHT_NOBITS) {
+                fileSize += sec->get_size() + pad;
+            }
+            pos += pad;
+            sec->set_address(seg->get_virtual_address() + pos - start);
+            secOff[index] = pos;
+            placed[index] = TRUE;
+            if (sec->get_type() != SHT_NOBITS) {
+                pos += sec->get_size();
+            }
+        }
+        seg->set_file_size(fileSize);
+        if (seg->get_memory_size() < memSize) {
+            seg->set_memory_size(memSize);
+        }
+        segOff[i] = start;
+    }
+
+    for (int i = 0; i < nSec; i++) {
+        if (placed[i]) {
+            continue;
+        }
+        section* sec = writer.sections[i];
+        Elf_Xword align = sec->get_addr_align();
+        if (align > 1 && pos % align != 0) {
+            pos += align - pos % align;
+        }
+        secOff[i] = (i == 0) ? 0 : pos;
+        if (sec->get_type() != SHT_NOBITS && sec->get_type() != SHT_NULL) {
+            pos += sec->get_size();
+        }
+    }
+    free(placed);
+
+    // the section header table goes last, 16-byte aligned
+    pos += 16 - pos % 16;
+    return pos;
+}
+
+/// \brief Destination of the ELF image: a mapped file or a stream.
+struct ELFImage {
+    char* i_map;    ///< Mapped output file, or NULL.
+    FILE* i_file;   ///< Output stream, used if i_map is NULL.
+    char* i_hdr;    ///< Zeroed buffer for the ELF and program headers.
+    char* i_sht;    ///< Zeroed buffer for the section header table.
+};
+
+/// \brief Store bytes at a file offset of the image.
+static void putImage(struct ELFImage* img, Elf64_Off offset, const char* bytes, size_t len) {
+    if (img->i_map != NULL) {
+        memcpy(img->i_map + offset, bytes, len);
+    }
+    else {
+        fseek(img->i_file, (long)offset, SEEK_SET);
+        fwrite(bytes, 1, len, img->i_file);
+    }
+}
+
+/// \brief Store instruction words big-endian at a file offset of the image.
+static void putImageWords(struct ELFImage* img, Elf64_Off offset, const uint32_t* words, size_t count) {
+    if (img->i_map != NULL) {
+        storeBigEndian32(img->i_map + offset, words, count);
+        return;
+    }
+    char chunk[4096];
+    while (count > 0) {
+        size_t n = (count < sizeof(chunk) / 4) ? count : sizeof(chunk) / 4;
+        storeBigEndian32(chunk, words, n);
+        putImage(img, offset, chunk, n * 4);
+        offset += n * 4;
+        words += n;
+        count -= n;
+    }
+}
+
+/// \brief Store the headers and section contents in the image.
+/// \param img    Destination.
+/// \param secOff File offset of each section.
+/// \param segOff File offset of each segment.
+/// \param shOff  File offset of the section header table.
+/// \details Allocates nothing and cannot fail, so the output file is never
+/// left mapped or open by a fatal error.
+static void storeElfImage(struct ELFImage* img, const Elf64_Off* secOff, const Elf64_Off* segOff, Elf64_Off shOff) {
+    int nSeg = writer.segments.size();
+    int nSec = writer.sections.size();
+    int ehSize = writer.get_header_size();
+    int phSize = writer.get_segment_entry_size();
+    int shSize = writer.get_section_entry_size();
+
+    // ELF header and program header table
+    char* hdr = img->i_hdr;
+    hdr[EI_MAG0] = ELFMAG0;
+    hdr[EI_MAG1] = ELFMAG1;
+    hdr[EI_MAG2] = ELFMAG2;
+    hdr[EI_MAG3] = ELFMAG3;
+    hdr[EI_CLASS] = writer.get_class();
+    hdr[EI_DATA] = writer.get_encoding();
+    hdr[EI_VERSION] = writer.get_elf_version();
+    hdr[EI_OSABI] = writer.get_os_abi();
+    hdr[EI_ABIVERSION] = writer.get_abi_version();
+    putBE16(hdr + 16, writer.get_type());
+    putBE16(hdr + 18, writer.get_machine());
+    putBE32(hdr + 20, writer.get_version());
+    putBE32(hdr + 24, (uint32_t)writer.get_entry());
+    putBE32(hdr + 28, (nSeg > 0) ? ehSize : 0);
+    putBE32(hdr + 32, (uint32_t)shOff);
+    putBE32(hdr + 36, writer.get_flags());
+    putBE16(hdr + 40, ehSize);
+    putBE16(hdr + 42, phSize);
+    putBE16(hdr + 44, nSeg);
+    putBE16(hdr + 46, shSize);
+    putBE16(hdr + 48, nSec);
+    putBE16(hdr + 50, writer.get_section_name_str_index());
+    for (int i = 0; i < nSeg; i++) {
+        segment* seg = writer.segments[i];
+        char* ph = hdr + ehSize + phSize * i;
+        putBE32(ph, seg->get_type());
+        putBE32(ph + 4, (uint32_t)segOff[i]);
+        putBE32(ph + 8, (uint32_t)seg->get_virtual_address());
+        putBE32(ph + 12, (uint32_t)seg->get_physical_address());
+        putBE32(ph + 16, (uint32_t)seg->get_file_size());
+        putBE32(ph + 20, (uint32_t)seg->get_memory_size());
+        putBE32(ph + 24, seg->get_flags());
+        putBE32(ph + 28, (uint32_t)seg->get_align());
+    }
+    putImage(img, 0, hdr, ehSize + phSize * nSeg);
+
+    // section contents: held by elfio (names, notes) or recorded as spans
+    for (int i = 0; i < nSec; i++) {
+        section* sec = writer.sections[i];
+        if (sec->get_type() != SHT_NOBITS && sec->get_size() > 0 && sec->get_data() != NULL) {
+            putImage(img, secOff[i], sec->get_data(), sec->get_size());
+        }
+    }
+    for (int i = 0; i < spanCount; i++) {
+        const struct ELFSpan* e = &spanTab[i];
+        Elf64_Off offset = secOff[e->e_section->get_index()] + e->e_offset;
+        if (e->e_bytes != NULL) {
+            putImage(img, offset, e->e_bytes, e->e_len);
+        }
+        else {
+            putImageWords(img, offset, e->e_words, e->e_len / 4);
+        }
+    }
+
+    // section header table
+    char* sht = img->i_sht;
+    for (int i = 1; i < nSec; i++) {
+        section* sec = writer.sections[i];
+        char* sh = sht + shSize * i;
+        putBE32(sh, sec->get_name_string_offset());
+        putBE32(sh + 4, sec->get_type());
+        putBE32(sh + 8, (uint32_t)sec->get_flags());
+        putBE32(sh + 12, (uint32_t)sec->get_address());
+        putBE32(sh + 16, (uint32_t)secOff[i]);
+        putBE32(sh + 20, (uint32_t)sec->get_size());
+        putBE32(sh + 24, sec->get_link());
+        putBE32(sh + 28, sec->get_info());
+        putBE32(sh + 32, (uint32_t)sec->get_addr_align());
+        putBE32(sh + 36, (uint32_t)sec->get_entry_size());
+    }
+    putImage(img, shOff, sht, shSize * nSec);
+}
+
 /// \brief Write the ELF file to disk.
 /// \details
-/// Sets the ELF entry point to the global entry point and writes
-/// the final ELF binary (`ASM32.out`) to disk.
-/// \return 0 on success.
+/// Sets the ELF entry point to the global entry point, computes the file
+/// layout and writes the 32-bit big-endian image that ::createELF set up.
+/// The output file is sized up front and mapped, headers and section
+/// contents are stored straight into it; gaps stay zero. Where `mmap` is
+/// not available (Windows) or fails, the parts are written with `fwrite`
+/// at their offsets. All buffers are allocated before the file is opened.
+/// \return 0 on success, 1 if the file could not be written.
 int writeElfFile(char* file) {
+    flushDataSection();
     writer.set_entry(elfEntryPoint);
-    writer.save(file);
-    return 0;
+
+    int nSeg = writer.segments.size();
+    int nSec = writer.sections.size();
+    Elf64_Off* secOff = (Elf64_Off*)calloc(nSec + nSeg + 1, sizeof(Elf64_Off));
+    if (secOff == NULL) {
+        fatalError("malloc failed");
+    }
+    Elf64_Off* segOff = secOff + nSec;
+    Elf64_Off shOff = layoutElf(secOff, segOff);
+    Elf64_Off size = shOff + (Elf64_Off)writer.get_section_entry_size() * nSec;
+
+    size_t hdrSize = writer.get_header_size() + (size_t)writer.get_segment_entry_size() * nSeg;
+    char* hdr = (char*)calloc(hdrSize + (size_t)writer.get_section_entry_size() * nSec, 1);
+    if (hdr == NULL) {
+        free(secOff);
+        fatalError("malloc failed");
+    }
+
+    struct ELFImage img = { NULL, NULL, hdr, hdr + hdrSize };
+    int status = 1;
+#ifndef _WIN32
+    int fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd >= 0 && ftruncate(fd, size) == 0) {
+        void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            img.i_map = (char*)map;
+            storeElfImage(&img, secOff, segOff, shOff);
+            status = (munmap(map, size) == 0) ? 0 : 1;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+    if (img.i_map == NULL) {
+        img.i_file = fopen(file, "wb");
+        if (img.i_file != NULL) {
+            storeElfImage(&img, secOff, segOff, shOff);
+            status = (fclose(img.i_file) == 0) ? 0 : 1;
+        }
+    }
+    free(hdr);
+    free(secOff);
+
+    if (status != 0) {
+        fprintf(stderr, "\n----- Output file \"%s\" could not be written -----\n\n", file);
+    }
+    return status;
+}
+
+
+// --------------------------------------------------------------------------------
+//  ELF Dump
+// --------------------------------------------------------------------------------
+
+/// \brief Hex dump of the contents of one section.
+/// \param sec      Section.
+/// \param maxBytes Bytes dumped at most (0: no limit).
+/// \details
+/// Code and data contents are read from the section spans, names and notes
+/// from elfio. Each line shows the address of its first byte.
+static void dumpSectionData(section* sec, int maxBytes) {
+    Elf_Xword size = sec->get_size();
+    Elf_Xword limit = (maxBytes > 0 && size > (Elf_Xword)maxBytes) ? maxBytes : size;
+    Elf64_Addr addr = sec->get_address();
+
+    printf("\n%s: %" PRIu64 " bytes at 0x%08" PRIX64 "\n", sec->get_name().c_str(), (uint64_t)size, (uint64_t)addr);
+    if (sec->get_type() == SHT_NOBITS) {
+        printf("  (zero filled, no file data)\n");
+        return;
+    }
+
+    Elf_Xword pos = 0;
+    const char* data = (size > 0) ? sec->get_data() : NULL;
+    if (data != NULL) {
+        for (; pos < limit; pos++) {
+            if (pos % 16 == 0) {
+                printf("%s  %08" PRIX64 ":", (pos > 0) ? "\n" : "", (uint64_t)(addr + pos));
+            }
+            printf(" %02X", data[pos] & 0xFF);
+        }
+    }
+    else {
+        for (int i = 0; i < spanCount && pos < limit; i++) {
+            const struct ELFSpan* e = &spanTab[i];
+            if (e->e_section != sec) {
+                continue;
+            }
+            for (Elf_Xword k = 0; k < e->e_len && pos < limit; k++, pos++) {
+                int byte;
+                if (e->e_bytes != NULL) {
+                    byte = e->e_bytes[k] & 0xFF;
+                }
+                else {
+                    byte = (e->e_words[k / 4] >> (24 - 8 * (k % 4))) & 0xFF;
+                }
+                if (pos % 16 == 0) {
+                    printf("%s  %08" PRIX64 ":", (pos > 0) ? "\n" : "", (uint64_t)(addr + pos));
+                }
+                printf(" %02X", byte);
+            }
+        }
+    }
+    if (pos > 0) {
+        printf("\n");
+    }
+    if (limit < size) {
+        printf("  ... %" PRIu64 " more bytes\n", (uint64_t)(size - limit));
+    }
+}
+
+/// \brief Dump the ELF file that was just written.
+/// \param parts       ELF_DUMP_ flags selecting the parts.
+/// \param sectionName Only dump the contents of this section (NULL: all).
+/// \param maxBytes    Bytes dumped per section at most (0: no limit).
+/// \details
+/// Works on the in-memory writer and the section spans after
+/// ::writeElfFile, so the file is not read back. Header tables and notes
+/// are printed by the elfio dump routines.
+void dumpElf(int parts, const char* sectionName, int maxBytes) {
+    if (parts & ELF_DUMP_HEADER) {
+        dump::header(std::cout, writer);
+    }
+    if (parts & ELF_DUMP_SECTIONS) {
+        dump::section_headers(std::cout, writer);
+    }
+    if (parts & ELF_DUMP_SEGMENTS) {
+        dump::segment_headers(std::cout, writer);
+    }
+    if (parts & ELF_DUMP_NOTES) {
+        dump::notes(std::cout, writer);
+    }
+    std::cout.flush();
+    if (parts & ELF_DUMP_DATA) {
+        bool found = FALSE;
+        for (int i = 1; i < (int)writer.sections.size(); i++) {
+            section* sec = writer.sections[i];
+            if (sectionName == NULL || sec->get_name() == sectionName) {
+                dumpSectionData(sec, maxBytes);
+                found = TRUE;
+            }
+        }
+        if (sectionName != NULL && found == FALSE) {
+            printf("\nsection %s not found\n", sectionName);
+        }
+    }
 }
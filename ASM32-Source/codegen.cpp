@@ -1,48 +1,253 @@
 #include "constants.hpp"
 #include "ASM32.hpp"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 /// \file
 /// \brief AST reader and binary generator
 /// \details
-/// This module reads the abstract syntax tree (AST) and the symbol table,
-/// translates instructions into binary form, and builds the final machine code
-/// representation. It provides helper functions for bit manipulation,
-/// register encoding, option parsing, and AST traversal.
+/// This module reads the instruction records built by the parser and the
+/// symbol table, translates instructions into binary form, and builds the
+/// final machine code representation. It provides the instruction field
+/// descriptors, register encoding and option parsing. Each code section
+/// is encoded as a job of its own, in parallel for large programs.
 
 // ============================================================================
-// Bit Manipulation Helpers
+// Code Generation Jobs
 // ============================================================================
+//
+// The instruction records are split into code sections: the instructions in
+// front of the first `.CODE` directive and one section per directive. The
+// layout of the sections (start address, alignment, entry point) only
+// depends on the directives and is settled in one serial pass. After that
+// every section is encoded on its own, on a pool of threads for large
+// programs. A section writes its instruction words, branch fixups, ADDIL
+// expansions and error messages into a codeJob of its own; the jobs are
+// joined in source order afterwards, so the result does not depend on the
+// number of threads.
+
+#define CODEGEN_PAR_MIN 4096            ///< Fewer instruction records are encoded on the calling thread.
+
+/// \brief Error message of an instruction, reported when the jobs are joined.
+struct codeError {
+    int e_lineNr;                       ///< Source line number.
+    const char* e_text;                 ///< Message (in j_text).
+};
+
+/// \brief ADDIL expansion, entered into the code shifts when the jobs are joined.
+struct codeExpansion {
+    uint32_t x_sectionId;               ///< Code section of the expanded instruction.
+    uint32_t x_codeAdr;                 ///< Parse-time address of the expanded instruction.
+};
+
+/// \brief One code section and the output of encoding it.
+struct codeJob {
+    const struct instrRecord* j_instr;  ///< Instruction records (::instrTab of the assembling thread).
+    int j_first;                        ///< First record (the `.CODE` record if j_header is set).
+    int j_end;                          ///< One past the last record.
+    bool j_header;                      ///< Section starts with a `.CODE` directive.
+    uint32_t j_nameId;                  ///< Interned section name.
+    uint32_t j_addr;                    ///< Section address.
+    uint32_t j_codeAdr;                 ///< Code address in front of the first instruction.
+    int j_binStatus;                    ///< bin_status in front of the first instruction.
+
+    struct BINSection j_section;        ///< Instruction words of the section.
+    struct branchFixup* j_fixups;       ///< Branches waiting for their label offset.
+    int j_fixupCount;                   ///< Number of entries in j_fixups.
+    struct codeExpansion* j_shifts;     ///< ADDIL expansions in source order.
+    int j_shiftCount;                   ///< Number of entries in j_shifts.
+    int j_shiftCapacity;                ///< Allocated entries in j_shifts.
+    struct codeError* j_errors;         ///< Error messages in the order they were raised.
+    int j_errorCount;                   ///< Number of entries in j_errors.
+    int j_errorCapacity;                ///< Allocated entries in j_errors.
+    struct arena j_text;                ///< Info texts and error messages.
+    int j_numOfInstructions;            ///< Instructions written to the BIN section.
+    bool j_addInstr;                    ///< Section has ADDIL expansions.
+    uint32_t j_codeAdrEnd;              ///< Code address after the last instruction.
+    int j_lineNrEnd;                    ///< Line of the last instruction.
+};
+
+static thread_local struct codeJob* curJob = NULL;  ///< Job being encoded on this thread.
+
+/// \brief Keep an error message of the current job for joinCodeJobs().
+static void deferError(const char* msg) {
+    struct codeJob* j = curJob;
+    if (j->j_errorCount == j->j_errorCapacity) {
+        j->j_errorCapacity = (j->j_errorCapacity == 0) ? 16 : j->j_errorCapacity * 2;
+        j->j_errors = (struct codeError*)realloc(j->j_errors, sizeof(struct codeError) * j->j_errorCapacity);
+        if (j->j_errors == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    struct codeError* e = &j->j_errors[j->j_errorCount++];
+    e->e_lineNr = lineNr;
+    e->e_text = arenaText(&j->j_text, msg);
+}
 
-/// \brief Set bits in the current instruction.
+/// \brief Record an ADDIL expansion of the current instruction.
 /// \details
-/// Inserts a value into a specific bit range of the current binary instruction.
-/// Performs range checks and signals errors if the input exceeds the allowed
-/// number of bits.
-/// 
-/// \param pos Position in the instruction (0 = MSB, 31 = LSB).
-/// \param x   Value to be inserted.
-/// \param num Number of bits.
+/// The expansion is entered with addCodeShift() when the jobs are joined.
+static void deferCodeShift() {
+    struct codeJob* j = curJob;
+    if (j->j_shiftCount == j->j_shiftCapacity) {
+        j->j_shiftCapacity = (j->j_shiftCapacity == 0) ? 64 : j->j_shiftCapacity * 2;
+        j->j_shifts = (struct codeExpansion*)realloc(j->j_shifts, sizeof(struct codeExpansion) * j->j_shiftCapacity);
+        if (j->j_shifts == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    struct codeExpansion* x = &j->j_shifts[j->j_shiftCount++];
+    x->x_sectionId = instrSectionId;
+    x->x_codeAdr = instrCodeAdr;
+}
 
-void setBit(int pos, int32_t x, int num) {
-    
-    int limit = pow(2, num);
+/// \brief Append the current instruction word to the section of the current job.
+/// \param addil TRUE for the ADDIL inserted in front of an instruction.
+/// \return Index of the word in the section.
+/// \details
+/// Words of an ADDIL expansion (B_BINCHILD) also get a note with the
+/// current info text.
+static int addBinWord(bool addil) {
+    struct BINSection* sec = &curJob->j_section;
+    if (sec->b_count == sec->b_capacity) {
+        sec->b_capacity = (sec->b_capacity == 0) ? 1024 : sec->b_capacity * 2;
+        sec->b_code = (uint32_t*)realloc(sec->b_code, sizeof(uint32_t) * sec->b_capacity);
+        if (sec->b_code == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    sec->b_code[sec->b_count] = binInstr;
+
+    if (bin_status == B_BINCHILD) {
+        if (sec->b_noteCount == sec->b_noteCapacity) {
+            sec->b_noteCapacity = (sec->b_noteCapacity == 0) ? 16 : sec->b_noteCapacity * 2;
+            sec->b_notes = (struct BINNote*)realloc(sec->b_notes, sizeof(struct BINNote) * sec->b_noteCapacity);
+            if (sec->b_notes == NULL) {
+                fatalError("realloc failed");
+            }
+        }
+        struct BINNote* n = &sec->b_notes[sec->b_noteCount++];
+        n->n_index = sec->b_count;
+        n->n_addil = addil;
+        n->n_infotext = arenaText(&curJob->j_text, infmsg);
+    }
+    return sec->b_count++;
+}
+
+
+// ============================================================================
+// Instruction Fields
+// ============================================================================
+//
+// A field of the 32-bit instruction word is described by its rightmost bit
+// (bits are numbered 0 = MSB to 31 = LSB, as in the VCPU-32 documentation),
+// its width and how a value is checked and scaled before it is inserted.
+// Masks and limits are plain integer constants; the descriptors below are
+// checked at compile time to fit into the word behind the 6-bit opcode.
+
+/// \brief Bit field of an instruction word.
+struct instrField {
+    int f_pos;          ///< Rightmost bit of the field (0 = MSB, 31 = LSB).
+    int f_width;        ///< Number of bits in the word.
+    int f_signed;       ///< Signed range in bits (after scaling), 0: +/-2^width.
+    int f_shift;        ///< Value is scaled by >> f_shift (byte to word offsets).
+};
+
+/// \brief Mask of a field of the given width (right-aligned).
+static constexpr uint32_t fieldMask(int width) {
+    return (width >= 32) ? 0xFFFFFFFFu : ((1u << width) - 1);
+}
+
+/// \brief 2^width, the bound of the range accepted by fields without a signed range.
+static constexpr int64_t fieldLimit(int width) {
+    return (int64_t)1 << width;
+}
+
+/// \brief TRUE if a field lies inside the word and behind the opcode.
+static constexpr bool fieldFits(const instrField& f) {
+    return f.f_width > 0 && f.f_pos <= 31 && f.f_pos - f.f_width + 1 >= 6 &&
+           f.f_signed <= f.f_width;
+}
+
+static constexpr instrField FLD_REG_R  = {  9,  4, 0, 0 };  ///< General register R.
+static constexpr instrField FLD_REG_A  = { 27,  4, 0, 0 };  ///< General register A.
+static constexpr instrField FLD_REG_B  = { 31,  4, 0, 0 };  ///< General register B.
+static constexpr instrField FLD_REG_MR = { 31,  5, 0, 0 };  ///< MR: segment or control register.
+static constexpr instrField FLD_SEG    = { 13,  2, 0, 0 };  ///< Segment register S1..S3 of a memory operand.
+
+static constexpr instrField FLD_MODE   = { 13,  2, 0, 0 };  ///< ALU operand mode (0..3).
+static constexpr instrField FLD_DW     = { 15,  2, 0, 0 };  ///< ALU data width (word, half, byte).
+static constexpr instrField FLD_INDEX  = { 10,  1, 0, 0 };  ///< LD, ST, LDA, STA: register indexed operand.
+
+static constexpr instrField FLD_OPT1   = { 10,  1, 0, 0 };  ///< First option letter.
+static constexpr instrField FLD_OPT2   = { 11,  1, 0, 0 };  ///< Second option letter.
+static constexpr instrField FLD_OPT3   = { 12,  1, 0, 0 };  ///< DEP: option I.
+static constexpr instrField FLD_OPT_F  = { 14,  1, 0, 0 };  ///< PCA: option F.
+static constexpr instrField FLD_COND   = { 11,  2, 0, 0 };  ///< CMP, CMPU: EQ, LT, NE, LE.
+static constexpr instrField FLD_CBR_COND = { 7, 2, 0, 0 };  ///< CBR, CBRU: EQ, LT, NE, LE.
+static constexpr instrField FLD_CMR_COND = { 13, 3, 0, 0 }; ///< CMR: EQ, LT, GT, EV, NE, LE, GE, OD.
+
+static constexpr instrField FLD_VAL4   = { 31,  4, 0, 0 };  ///< DEP, MST: immediate value.
+static constexpr instrField FLD_VAL18  = { 31, 18, 0, 0 };  ///< ALU mode 0: immediate value.
+static constexpr instrField FLD_VAL22  = { 31, 22, 0, 0 };  ///< ADDIL, LDIL: immediate value.
+static constexpr instrField FLD_OFS12  = { 27, 12, 0, 0 };  ///< Memory operand: byte offset.
+static constexpr instrField FLD_OFS18  = { 27, 18, 0, 0 };  ///< LDO: byte offset.
+static constexpr instrField FLD_POS    = { 27,  5, 0, 0 };  ///< EXTR, DEP: bit position.
+static constexpr instrField FLD_LEN    = { 21,  5, 0, 0 };  ///< EXTR, DEP: field length.
+static constexpr instrField FLD_SHAMT  = { 21,  5, 0, 0 };  ///< DSR: shift amount.
+static constexpr instrField FLD_SA     = { 21,  2, 0, 0 };  ///< SHLA: shift amount.
+static constexpr instrField FLD_INFO1  = {  9,  4, 0, 0 };  ///< BRK: info1.
+static constexpr instrField FLD_INFO2  = { 31, 16, 0, 0 };  ///< BRK: info2.
+static constexpr instrField FLD_DIAG   = { 13,  4, 0, 0 };  ///< DIAG: info.
+
+static constexpr instrField FLD_OFS22  = { 31, 22, 21, 2 }; ///< B, GATE: word offset.
+static constexpr instrField FLD_OFS16  = { 23, 16, 16, 2 }; ///< CBR, CBRU: word offset.
+static constexpr instrField FLD_OFS14  = { 23, 14, 14, 2 }; ///< BE: word offset.
+
+static_assert(fieldFits(FLD_REG_R) && fieldFits(FLD_REG_A) && fieldFits(FLD_REG_B) &&
+              fieldFits(FLD_REG_MR) && fieldFits(FLD_SEG), "register field outside the instruction word");
+static_assert(fieldFits(FLD_MODE) && fieldFits(FLD_DW) && fieldFits(FLD_INDEX) &&
+              fieldFits(FLD_OPT1) && fieldFits(FLD_OPT2) && fieldFits(FLD_OPT3) && fieldFits(FLD_OPT_F) &&
+              fieldFits(FLD_COND) && fieldFits(FLD_CBR_COND) && fieldFits(FLD_CMR_COND), "option field outside the instruction word");
+static_assert(fieldFits(FLD_VAL4) && fieldFits(FLD_VAL18) && fieldFits(FLD_VAL22) &&
+              fieldFits(FLD_OFS12) && fieldFits(FLD_OFS18) && fieldFits(FLD_POS) && fieldFits(FLD_LEN) &&
+              fieldFits(FLD_SHAMT) && fieldFits(FLD_SA) && fieldFits(FLD_INFO1) && fieldFits(FLD_INFO2) &&
+              fieldFits(FLD_DIAG), "immediate field outside the instruction word");
+static_assert(fieldFits(FLD_OFS22) && fieldFits(FLD_OFS16) && fieldFits(FLD_OFS14), "offset field outside the instruction word");
+static_assert(fieldMask(FLD_OFS22.f_width) == 0x3FFFFF && fieldMask(FLD_OFS16.f_width) == 0xFFFF, "offset field masks");
+
+/// \brief Insert a value into an empty field of the current instruction.
+/// \param f Field descriptor.
+/// \param x Value, already scaled and range checked.
+static inline void putField(const instrField& f, int32_t x) {
+    binInstr = binInstr | (int)(((uint32_t)x & fieldMask(f.f_width)) << (31 - f.f_pos));
+}
+
+/// \brief Range check a value and insert it into a field.
+/// \param f Field descriptor.
+/// \param x Value (not scaled).
+/// \details
+/// Fields without a signed range accept -2^width .. 2^width-1 (the high
+/// bits of negative values are cut off).
+static inline void setField(const instrField& f, int32_t x) {
+    int64_t limit = fieldLimit(f.f_signed ? f.f_signed - 1 : f.f_width);
     if (x > (limit - 1) ||
         x < (-limit)) {
 
         snprintf(errmsg, sizeof(errmsg), "Value %d out of range", x);
         processError(errmsg);
     }
-    int mask = pow(2, num) - 1;
-    int val = (x & mask);
-    binInstr = binInstr | val << (31 - pos);
+    putField(f, x);
 }
 
-/// \brief Clear a single bit in the current instruction.
-/// \param pos Position in the instruction (0 = MSB, 31 = LSB).
-void clrBit(int pos) {
-
-    binInstr &= ~(1 << (31 - pos));
-
+/// \brief Clear a field of the current instruction.
+/// \param f Field descriptor.
+static inline void clrField(const instrField& f) {
+    binInstr &= ~(int)(fieldMask(f.f_width) << (31 - f.f_pos));
 }
 
 /// \brief Set an instruction offset field.
@@ -51,12 +256,10 @@ void clrBit(int pos) {
 /// offset exceeds the field width. Supports special handling for offsets larger
 /// than the hardware limit.
 /// 
-/// \param pos Position in the instruction.
-/// \param x   Offset value.
-/// \param num Number of bits available for encoding.
-void setDataOffset(int pos, int offset, int len) {
-    int num;
-    int limit = pow(2, len);
+/// \param f      Offset field (FLD_OFS12 or FLD_OFS18).
+/// \param offset Offset value.
+static void setDataOffset(const instrField& f, int offset) {
+    int64_t limit = fieldLimit(f.f_width);
     addInstrLine = FALSE;
     
         if (offset > (limit - 1) ||
@@ -74,38 +277,28 @@ void setDataOffset(int pos, int offset, int len) {
             binInstr = 0x08000000 | (0xFFFFFC00 & offset);
             // adjust basereg 
 
-            setGenRegister('R', baseRegData);
+            setGenRegister('R', opBaseReg);
             bin_status = B_BINCHILD;
-            sprintf(infmsg, "       offset: -->  ADDIL %s,L%%%d\n", baseRegData, offset);
+            sprintf(infmsg, "       offset: -->  ADDIL %s,L%%%d\n", opBaseReg, offset);
 
             codeAdr = codeAdr - 4;
-            createBINEntry();
-            ptr_b->b_type = 1;
-            ptr_b->b_lineNr = lineNr;
-            ptr_b->b_codeAdr = codeAdr;
-            ptr_b->b_binInstr = binInstr;
-            ptr_b->b_bin_status = bin_status;
-            strcpy(ptr_b->b_infotext, infmsg);
+            addBinWord(TRUE);
 
             codeAdr = codeAdr + 4;
             binInstr = binInstrSave;
-            binInstr = binInstr & 0xFFFFFFF0;
-            strcpy(opchar[2], "R1");
+            clrField(FLD_REG_B);
+            opchar[2] = "R1";
             sprintf(infmsg, "       offset: -->  <OPCODE> %s,R%%%d(R1)\n", opchar[0], offset);
 
             setGenRegister('B', opchar[2]);
 
             opnum[1] = 0;
 
-        }
-        if (AST_numInstr == 1) {
             addInstrGlob = TRUE;
             addInstrLine = TRUE;
-            updSYM(GlobalSYM, 0);
+            deferCodeShift();
         }
-    int mask = pow(2, len) - 1;
-    num = (offset & mask);
-    setBit(27, num, len);
+    setField(f, offset & (int)fieldMask(f.f_width));
 }
 
 
@@ -114,13 +307,10 @@ void setDataOffset(int pos, int offset, int len) {
 /// \details
 /// checks if offset exceeds the field width.
 /// 
-/// \param pos Position in the instruction.
-/// \param offset   Offset value.
-/// \param num Number of bits available for encoding.
-bool checkBranchOffset(int pos, int offset, int len) {
-    int num;
-    int limit = pow(2, len -1);
-    limit = limit * 4;          // due to shift >> 2
+/// \param f       Offset field (signed range and scaling).
+/// \param offset  Offset value in bytes.
+static bool checkBranchOffset(const instrField& f, int offset) {
+    int limit = (int)(fieldLimit(f.f_signed - 1) << f.f_shift);
     if (offset > 0) {
         if (offset > (limit - 1)) {
             snprintf(errmsg, sizeof(errmsg), "Offset %d out of range for this instruction limit = %d", offset, limit -1);
@@ -139,6 +329,101 @@ bool checkBranchOffset(int pos, int offset, int len) {
 }
 
 
+// ============================================================================
+// Branch Fixups
+// ============================================================================
+//
+// The offset of a branch to a label is the only encoding that depends on the
+// final code layout, and it never changes the size of the instruction. The
+// codegen pass therefore leaves the offset field of such branches empty and
+// records them here; once the pass is done, every ADDIL expansion is known
+// (see addCodeShift()) and resolveBranchFixups() encodes each offset once.
+// Since no fixup changes a size, one sweep reaches the fixed point.
+
+/// \brief Branch instruction waiting for its label offset.
+struct branchFixup {
+    int f_section;                      ///< Index of the code section in binTab (set when the jobs are joined).
+    int f_word;                         ///< Index of the branch in the section.
+    int f_codeAdr;                      ///< Code address of the branch.
+    int f_lineNr;                       ///< Source line of the branch.
+    SymNode* f_sym;                     ///< Target label.
+    uint32_t f_nameId;                  ///< Interned first operand (for messages).
+    const instrField* f_field;          ///< Offset field (FLD_OFS22 or FLD_OFS16).
+};
+
+static thread_local struct branchFixup* fixupTab = NULL;     ///< Recorded branches.
+static thread_local int fixupCount = 0;                      ///< Number of entries in fixupTab.
+static thread_local int fixupCapacity = 0;                   ///< Allocated entries in fixupTab.
+static thread_local SymNode* branchSym = NULL;               ///< Target of the instruction being encoded.
+static thread_local const instrField* branchField = NULL;     ///< Offset field of the instruction being encoded.
+
+/// \brief Leave the label offset of the current instruction for resolveBranchFixups().
+/// \param sym Target label.
+/// \param field Offset field of the instruction.
+static void deferBranch(SymNode* sym, const instrField& field) {
+    branchSym = sym;
+    branchField = &field;
+}
+
+/// \brief Record the deferred branch of the instruction just written to the BIN section.
+/// \param word Index of the instruction in the section.
+static void addBranchFixup(int word) {
+    if (fixupCount == fixupCapacity) {
+        fixupCapacity = (fixupCapacity == 0) ? 256 : fixupCapacity * 2;
+        fixupTab = (struct branchFixup*)realloc(fixupTab, sizeof(struct branchFixup) * fixupCapacity);
+        if (fixupTab == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    struct branchFixup* f = &fixupTab[fixupCount++];
+    f->f_section = 0;
+    f->f_word = word;
+    f->f_codeAdr = codeAdr;
+    f->f_lineNr = lineNr;
+    f->f_sym = branchSym;
+    f->f_nameId = opId[0];
+    f->f_field = branchField;
+    branchSym = NULL;
+}
+
+/// \brief Encode the label offsets of all recorded branches.
+/// \details
+/// Runs after the codegen pass, when the final address of every label is
+/// known. The offset is relative to the branch's own address.
+void resolveBranchFixups() {
+    for (int i = 0; i < fixupCount; i++) {
+        struct branchFixup* f = &fixupTab[i];
+        uint32_t* word = &binTab[f->f_section].b_code[f->f_word];
+        binInstr = *word;
+        codeAdr = f->f_codeAdr;
+        lineNr = f->f_lineNr;
+
+        value = (int64_t)getSymCodeAdr(f->f_sym) - codeAdr + 4;
+        if (checkBranchOffset(*f->f_field, value) == TRUE) {
+
+            if ((value & ((1 << f->f_field->f_shift) - 1)) != 0) {
+                snprintf(errmsg, sizeof(errmsg), "Label %s not on word boundary", internText(f->f_nameId));
+                processError(errmsg);
+            }
+            value = value >> f->f_field->f_shift;
+            putField(*f->f_field, value);
+        }
+        else {
+            snprintf(errmsg, sizeof(errmsg), "offset too big");
+            processError(errmsg);
+        }
+        if (DBG_GENBIN == TRUE) {
+            printf("branch line %03d addroffset= %d\n", lineNr, (int)value);
+        }
+
+        *word = binInstr;
+    }
+    free(fixupTab);
+    fixupTab = NULL;
+    fixupCount = 0;
+    fixupCapacity = 0;
+}
+
 
 // ============================================================================
 // Register Encoding Helpers
@@ -152,10 +437,13 @@ bool checkBranchOffset(int pos, int offset, int len) {
 /// \param reg     Register type ('R', 'A', or 'B').
 /// \param regname Name of the register, e.g., "R12".
 
-void setGenRegister(int reg, char* regname) {
+void setGenRegister(int reg, const char* regname) {
 
     int x = strlen(regname);
     char t[2];
+    if (x < 2) {
+        return;             // operand missing, the parser has reported the line
+    }
     if (x == 2) {
     
         t[0] = regname[1];
@@ -174,9 +462,9 @@ void setGenRegister(int reg, char* regname) {
         return; 
     }
     switch (reg) {
-    case 'R':   setBit(9, value,4); break;
-    case 'A':   setBit(27, value,4); break;
-    case 'B':   setBit(31, value,4); break;
+    case 'R':   setField(FLD_REG_R, value); break;
+    case 'A':   setField(FLD_REG_A, value); break;
+    case 'B':   setField(FLD_REG_B, value); break;
     }
 
 }
@@ -187,10 +475,13 @@ void setGenRegister(int reg, char* regname) {
 /// register number ranges and signals errors for invalid names.
 /// 
 /// \param regname Register name, e.g., "S1" or "C12".
-void setMRRegister(char* regname) {
+void setMRRegister(const char* regname) {
 
     int x = strlen(regname);
     char t[2];
+    if (x < 2) {
+        return;             // operand missing, the parser has reported the line
+    }
     if (x == 2) {
 
         t[0] = regname[1];
@@ -218,7 +509,7 @@ void setMRRegister(char* regname) {
             return;
         }
     }
-    setBit(31, value, 5);
+    setField(FLD_REG_MR, value);
 }
 
 /// \brief Retrieve a segment register number.
@@ -229,10 +520,13 @@ void setMRRegister(char* regname) {
 /// \param regname Segment register name (e.g., "S1").
 /// \return The numeric value (17) or 0 on error.
 
-int getSegRegister(char* regname) {
+int getSegRegister(const char* regname) {
 
     int x = strlen(regname);
     char t[2];
+    if (x < 2) {
+        return 0;             // operand missing, the parser has reported the line
+    }
     if (x == 2) {
 
         t[0] = regname[1];
@@ -288,8 +582,8 @@ void genBinOption() {
 
             switch (option[0][j]) {
 
-            case 'L':   setBit(10, 1, 1); break;
-            case 'O':   setBit(11, 1, 1); break;
+            case 'L':   setField(FLD_OPT1, 1); break;
+            case 'O':   setField(FLD_OPT2, 1); break;
             default:    snprintf(errmsg, sizeof(errmsg), "Invalid Option %c", option[0][j]); 
                 processError(errmsg);
             }
@@ -315,8 +609,8 @@ void genBinOption() {
         for (int j = 0; j < strlen(option[0]); j++) {
             switch (option[0][j]) {
 
-            case 'N':   setBit(10, 1, 1); break;
-            case 'C':   setBit(11, 1, 1); break;
+            case 'N':   setField(FLD_OPT1, 1); break;
+            case 'C':   setField(FLD_OPT2, 1); break;
             default:    snprintf(errmsg, sizeof(errmsg), "Invalid Option %c", option[0][j]);    
                 processError(errmsg);
             }
@@ -330,14 +624,13 @@ void genBinOption() {
 
         }
         else if (option[0][0] == 'L' && option[0][1] == 'T') {
-            setBit(11, 1, 1);
+            setField(FLD_COND, 1);
         }
         else if (option[0][0] == 'N' && option[0][1] == 'E') {
-            setBit(10, 1, 1);
+            setField(FLD_COND, 2);
         }
         else if (option[0][0] == 'L' && option[0][1] == 'E') {
-            setBit(10, 1, 1);
-            setBit(11, 1, 1);
+            setField(FLD_COND, 3);
         }
         else {
             if (option[0][0] == '\0') {
@@ -356,14 +649,13 @@ void genBinOption() {
         if (option[0][0] == 'E' && option[0][1] == 'Q') {
 
         } else if (option[0][0] == 'L' && option[0][1] == 'T') {
-            setBit(7, 1, 1);
+            setField(FLD_CBR_COND, 1);
         }
         else if (option[0][0] == 'N' && option[0][1] == 'E') {
-            setBit(6, 1, 1);
+            setField(FLD_CBR_COND, 2);
         }
         else if (option[0][0] == 'L' && option[0][1] == 'E') {
-            setBit(6, 1, 1);
-            setBit(7, 1, 1);
+            setField(FLD_CBR_COND, 3);
         }
         else {
             if (option[0][0] == '\0') {
@@ -383,7 +675,7 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'N':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             default:
@@ -405,30 +697,25 @@ void genBinOption() {
 
         }
         else if (option[0][0] == 'L' && option[0][1] == 'T') {
-            setBit(13, 1, 1);
+            setField(FLD_CMR_COND, 1);
         }
         else if (option[0][0] == 'G' && option[0][1] == 'T') {
-            setBit(12, 1, 1);
+            setField(FLD_CMR_COND, 2);
         }
         else if (option[0][0] == 'E' && option[0][1] == 'V') {
-            setBit(12, 1, 1);
-            setBit(13, 1, 1);
+            setField(FLD_CMR_COND, 3);
         }
         else if (option[0][0] == 'N' && option[0][1] == 'E') {
-            setBit(11, 1, 1);
+            setField(FLD_CMR_COND, 4);
         }
         else if (option[0][0] == 'L' && option[0][1] == 'E') {
-            setBit(11, 1, 1);
-            setBit(13, 1, 1);
+            setField(FLD_CMR_COND, 5);
         }
         else if (option[0][0] == 'G' && option[0][1] == 'E') {
-            setBit(11, 1, 1);
-            setBit(12, 1, 1);
+            setField(FLD_CMR_COND, 6);
         }
         else if (option[0][0] == 'O' && option[0][1] == 'D') {
-            setBit(11, 1, 1);
-            setBit(12, 1, 1);
-            setBit(13, 1, 1);
+            setField(FLD_CMR_COND, 7);
         }
         else {
             snprintf(errmsg, sizeof(errmsg), "Invalid Option %c%c", option[0][0], option[0][1]);
@@ -445,11 +732,11 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'S':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             case 'A':
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 mode = 1;
                 break;
 
@@ -467,15 +754,15 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'T':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             case 'M':
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 break;
 
             case 'F':
-                setBit(14, 1, 1);
+                setField(FLD_OPT_F, 1);
                 break;
 
             default:
@@ -492,11 +779,11 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'T':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             case 'M':
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 break;
 
             default:
@@ -513,7 +800,7 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'T':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             default:
@@ -530,7 +817,7 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'A':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             default:
@@ -547,11 +834,11 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'D':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             case 'M':
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 break;
 
             default:
@@ -570,11 +857,11 @@ void genBinOption() {
             break;
 
         case 'S':
-            setBit(11, 1, 1);
+            setField(FLD_OPT2, 1);
             break;
 
         case 'C':
-            setBit(10, 1, 1);
+            setField(FLD_OPT1, 1);
             break;
 
         default:
@@ -591,11 +878,11 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'W':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             case 'I':
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 break;
 
             default:
@@ -612,15 +899,15 @@ void genBinOption() {
             switch (option[0][j]) {
 
             case 'Z':
-                setBit(10, 1, 1);
+                setField(FLD_OPT1, 1);
                 break;
 
             case 'A':
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 break;
 
             case 'I':
-                setBit(12, 1, 1);
+                setField(FLD_OPT3, 1);
                 break;
 
             default:
@@ -640,7 +927,7 @@ void genBinOption() {
 
             case 'M':
 
-                setBit(11, 1, 1);
+                setField(FLD_OPT2, 1);
                 break;
 
             default:
@@ -682,11 +969,10 @@ void genBinInstruction() {
         if (mode == 0) {
 
             setGenRegister('R', opchar[0]);
-            setBit(31, opnum[1], 18);
+            setField(FLD_VAL18, opnum[1]);
             // no BYTE,HALF,WORD
-            clrBit(15);
-            clrBit(14);
-            setBit(31, opnum[1], 18);
+            clrField(FLD_DW);
+            setField(FLD_VAL18, opnum[1]);
         }
         else if (mode == 1) {
  
@@ -700,41 +986,39 @@ void genBinInstruction() {
                 setGenRegister('A', opchar[1]);
                 setGenRegister('B', opchar[2]);
             }
-            setBit(13, 1,1);
+            setField(FLD_MODE, 1);
             // no BYTE,HALF,WORD
-            clrBit(15);
-            clrBit(14);
-            setBit(31, opnum[1], 18);
+            clrField(FLD_DW);
+            setField(FLD_VAL18, opnum[1]);
         }
         else if (mode == 2) {
 
             setGenRegister('R', opchar[0]);
             setGenRegister('A', opchar[1]);
             setGenRegister('B', opchar[2]);
-            setBit(12, 1,1);
+            setField(FLD_MODE, 2);
         }
         else if (mode == 3) {
 
             setGenRegister('R', opchar[0]);
             if (operandTyp[1] == OT_MEMGLOB) {
 
-                strcpy(opchar[2], baseRegData);
+                opchar[2] = opBaseReg;
                 setGenRegister('B', opchar[2]);
-                setDataOffset(27, opnum[1], 12);
+                setDataOffset(FLD_OFS12, opnum[1]);
 
             } else if (operandTyp[1] == OT_MEMLOC) {
 
-                strcpy(opchar[2], "R15");
+                opchar[2] = "R15";
                 setGenRegister('B', opchar[2]);
-                setDataOffset(27, opnum[1], 12);
+                setDataOffset(FLD_OFS12, opnum[1]);
 
             } else if (operandTyp[1] == OT_VALUE) {
 
                 setGenRegister('B', opchar[2]);
-                setBit(27, opnum[1], 12);           // offset
+                setField(FLD_OFS12, opnum[1]);           // offset
             }
-            setBit(12, 1,1);
-            setBit(13, 1,1);
+            setField(FLD_MODE, 3);
         }
         break;
 
@@ -745,7 +1029,7 @@ void genBinInstruction() {
     case LDIL:
         setGenRegister('R', opchar[0]);
         num = opnum[1];
-        setBit(31, num, 22);
+        setField(FLD_VAL22, num);
         break;
 
     case B:
@@ -758,36 +1042,14 @@ void genBinInstruction() {
             }
             else
             {
-                value = opnum[0] >> 2;
-                setBit(31, value, 22);
+                value = opnum[0] >> FLD_OFS22.f_shift;
+                setField(FLD_OFS22, value);
             }
         }
 
         if (operandTyp[0] == OT_LABEL) {
-            searchScopeLevel = currentScopeLevel;
-            symFound = FALSE;
-
-            searchSymLevel(currentSymSave, opchar[0], 0);
-            if (symFound == TRUE) {
-
-                value = symcodeAdr - codeAdr + 4;
-                if (checkBranchOffset(31, value, 21) == TRUE) {
-
-                    if ((value % 4) != 0) {
-                        snprintf(errmsg, sizeof(errmsg), "Label %s not on word boundary", opchar[0]);
-                        processError(errmsg);
-                    }
-                    value = value >> 2;
-                    if (value < 0) {
-                        binInstr = binInstr | 0x3fffff;  // ensure offset is neagtive
-                    }
-                    setBit(31, value, 22);
-                }
-                else {
-                    snprintf(errmsg, sizeof(errmsg), "offset too big");
-                    processError(errmsg);
-                }
-                
+            if (opSym[0] != NULL) {
+                deferBranch(opSym[0], FLD_OFS22);
             }
             else
             {
@@ -819,34 +1081,14 @@ void genBinInstruction() {
             }
             else
             {
-                value = opnum[1] >> 2;
-                setBit(31, value, 22);
+                value = opnum[1] >> FLD_OFS22.f_shift;
+                setField(FLD_OFS22, value);
             }
         }
 
         if (operandTyp[1] == OT_LABEL) {
-            searchScopeLevel = currentScopeLevel;
-            symFound = FALSE;
-
-            searchSymLevel(currentSymSave, opchar[1], 0);
-            if (symFound == TRUE) {
-                value = symcodeAdr - codeAdr + 4;
-                if (checkBranchOffset(31, value, 21) == TRUE) {
-
-                    if ((value % 4) != 0) {
-                        snprintf(errmsg, sizeof(errmsg), "Label %s not on word boundary", opchar[0]);
-                        processError(errmsg);
-                    }
-                    value = value >> 2;
-                    if (value < 0) {
-                        binInstr = binInstr | 0x3fffff;  // ensure offset is neagtive
-                    }
-                    setBit(31, value, 22);
-                }
-                else {
-                    snprintf(errmsg, sizeof(errmsg), "offset too big");
-                    processError(errmsg);
-                }
+            if (opSym[1] != NULL) {
+                deferBranch(opSym[1], FLD_OFS22);
             }
             else
             {
@@ -882,35 +1124,14 @@ void genBinInstruction() {
             }
             else
             {
-                value = opnum[2] >> 2;
-                setBit(23, value, 16);
+                value = opnum[2] >> FLD_OFS16.f_shift;
+                setField(FLD_OFS16, value);
             }
         }
 
         if (operandTyp[2] == OT_LABEL) {
-            searchScopeLevel = currentScopeLevel;
-            symFound = FALSE;
-
-            searchSymLevel(currentSymSave, opchar[2], 0);
-            if (symFound == TRUE) {
-                value = symcodeAdr - codeAdr + 4;
-                if (checkBranchOffset(13, value, 16) == TRUE) {
-
-                    if ((value % 4) != 0) {
-
-                        snprintf(errmsg, sizeof(errmsg), "Label %s not on word boundary", opchar[0]);
-                        processError(errmsg);
-                    }
-                    value = value >> 2;
-                    if (value < 0) {
-                        binInstr = binInstr | 0xffff << 8;  // ensure offset is neagtive
-                    }
-                    setBit(23, value, 16);
-                }
-                else {
-                    snprintf(errmsg, sizeof(errmsg), "offset too big");
-                    processError(errmsg);
-                }
+            if (opSym[2] != NULL) {
+                deferBranch(opSym[2], FLD_OFS16);
             }
             else
             {
@@ -942,11 +1163,11 @@ void genBinInstruction() {
         setGenRegister('R', opchar[0]);
         setGenRegister('B', opchar[1]);
         if (mode == 0) {
-            setBit(27, opnum[2], 5);
-            setBit(21, opnum[3], 5);
+            setField(FLD_POS, opnum[2]);
+            setField(FLD_LEN, opnum[3]);
         }
         else {
-            setBit(21, opnum[2], 5);
+            setField(FLD_LEN, opnum[2]);
         }
         break;
 
@@ -956,27 +1177,27 @@ void genBinInstruction() {
 
             setGenRegister('R', opchar[0]);
             setGenRegister('B', opchar[1]);
-            setBit(27, opnum[2], 5);
-            setBit(21, opnum[3], 5);
+            setField(FLD_POS, opnum[2]);
+            setField(FLD_LEN, opnum[3]);
         }
         else if (mode == 1) {
 
             setGenRegister('R', opchar[0]);
             setGenRegister('B', opchar[1]);
-            setBit(21, opnum[2], 5);
+            setField(FLD_LEN, opnum[2]);
         }
         else if (mode == 2) {
 
             setGenRegister('R', opchar[0]);
-            setBit(31, opnum[1], 4);
-            setBit(27, opnum[2], 5);
-            setBit(21, opnum[3], 5);
+            setField(FLD_VAL4, opnum[1]);
+            setField(FLD_POS, opnum[2]);
+            setField(FLD_LEN, opnum[3]);
         }
         else if (mode == 3) {
 
             setGenRegister('R', opchar[0]);
-            setBit(31, opnum[1], 4);
-            setBit(21, opnum[2], 5);
+            setField(FLD_VAL4, opnum[1]);
+            setField(FLD_LEN, opnum[2]);
         }
         break;
 
@@ -986,19 +1207,19 @@ void genBinInstruction() {
 
         setGenRegister('R', opchar[0]);
         if (operandTyp[1] == OT_VALUE) {
-            setBit(27, opnum[1], 12);
+            setField(FLD_OFS12, opnum[1]);
             value = opnum[0];
         }
         else if (operandTyp[1] == OT_MEMGLOB) {
 
-            strcpy(opchar[2], baseRegData);
+            opchar[2] = opBaseReg;
             setGenRegister('B', opchar[2]);
-            setDataOffset(27, opnum[1], 12);
+            setDataOffset(FLD_OFS12, opnum[1]);
         }
         if (opchar[2][0] == 'S') {
             value = getSegRegister(opchar[2]);
             if (value > 0 && value < 4) {
-                setBit(13, value, 2);
+                setField(FLD_SEG, value);
             }
             else {
                 snprintf(errmsg, sizeof(errmsg), "Segmentregister S%d not allowed\n", (int)value);
@@ -1016,9 +1237,14 @@ void genBinInstruction() {
 
         if (operandTyp[0] == OT_VALUE) {
 
-            checkBranchOffset(23, value, 14);
-            setBit(23, opnum[0] >> 2, 14);
-
+            if ((opnum[0] % 4) != 0) {
+                snprintf(errmsg, sizeof(errmsg), "Value %d not on word boundary", opnum[0]);
+                processError(errmsg);
+            }
+            else if (checkBranchOffset(FLD_OFS14, opnum[0]) == TRUE) {
+                value = opnum[0] >> FLD_OFS14.f_shift;
+                setField(FLD_OFS14, value);
+            }
 
             setGenRegister('A', opchar[1]);
             setGenRegister('B', opchar[2]);
@@ -1031,8 +1257,8 @@ void genBinInstruction() {
 
     case BRK:
         
-        setBit(9, opnum[0], 4);
-        setBit(31, opnum[1], 16);
+        setField(FLD_INFO1, opnum[0]);
+        setField(FLD_INFO2, opnum[1]);
 
         break;
 
@@ -1042,7 +1268,7 @@ void genBinInstruction() {
         setGenRegister('A', opchar[1]);
         setGenRegister('B', opchar[2]);
         if (strcmp(opchar[3], "") != 0) {
-            setBit(21, opnum[3], 5);
+            setField(FLD_SHAMT, opnum[3]);
         }
         break;
 
@@ -1051,7 +1277,7 @@ void genBinInstruction() {
         setGenRegister('R', opchar[0]);
         setGenRegister('A', opchar[1]);
         setGenRegister('B', opchar[2]);
-        setBit(21, opnum[3], 2);
+        setField(FLD_SA, opnum[3]);
         break;
 
     case PCA:
@@ -1061,7 +1287,7 @@ void genBinInstruction() {
         if (opchar[1][0] == 'S') {
             value = getSegRegister(opchar[2]);
             if (value > 0 && value < 4) {
-                setBit(13, value, 2);
+                setField(FLD_SEG, value);
             }
             else {
                 snprintf(errmsg, sizeof(errmsg), "Segmentregister S%d not allowed\n", (int) value);
@@ -1088,7 +1314,7 @@ void genBinInstruction() {
         setGenRegister('R', opchar[0]);
         setGenRegister('A', opchar[1]);
         setGenRegister('B', opchar[2]);
-        setBit(13, opnum[3], 4);
+        setField(FLD_DIAG, opnum[3]);
         break;
 
     case ITLB:
@@ -1103,22 +1329,22 @@ void genBinInstruction() {
         setGenRegister('R', opchar[0]);
         if (operandTyp[1] == OT_MEMGLOB) {
 
-            strcpy(opchar[2], baseRegData);
+            opchar[2] = opBaseReg;
             setGenRegister('B', opchar[2]);
-            setDataOffset(27, opnum[1], 18);
+            setDataOffset(FLD_OFS18, opnum[1]);
 
         }
         else if (operandTyp[1] == OT_MEMLOC) {
 
-            strcpy(opchar[2], "R15");
+            opchar[2] = "R15";
             setGenRegister('B', opchar[2]);
-            setDataOffset(27, opnum[1], 18);
+            setDataOffset(FLD_OFS18, opnum[1]);
 
         }
         else if (operandTyp[1] == OT_VALUE) {
 
             setGenRegister('B', opchar[2]);
-            setBit(27, opnum[1], 18);           // offset
+            setField(FLD_OFS18, opnum[1]);           // offset
         }
         break;
 
@@ -1134,7 +1360,7 @@ void genBinInstruction() {
         if (opchar[1][0] == 'S') {
             value = getSegRegister(opchar[2]);
             if (value > 0 && value < 4) {
-                setBit(13, value, 2);
+                setField(FLD_SEG, value);
             }
             else {
                 snprintf(errmsg, sizeof(errmsg), "Segmentregister S%d not allowed\n", (int)value);
@@ -1164,7 +1390,7 @@ void genBinInstruction() {
         if (opchar[2][0] == 'S') {
             value = getSegRegister(opchar[2]);
             if (value > 0 && value < 4) {
-                setBit(13, value, 2);
+                setField(FLD_SEG, value);
             }
             else {
                 snprintf(errmsg, sizeof(errmsg), "Segmentregister S%d not allowed\n", (int)value);
@@ -1203,7 +1429,7 @@ void genBinInstruction() {
             setGenRegister('B', opchar[1]);
         }
         else {
-            setBit(31, opnum[1], 4);
+            setField(FLD_VAL4, opnum[1]);
         }
         break;
 
@@ -1217,23 +1443,23 @@ void genBinInstruction() {
 
         setGenRegister('R', opchar[0]);
         if (operandTyp[1] == OT_VALUE) {
-            setBit(27, opnum[1], 12);
+            setField(FLD_OFS12, opnum[1]);
             value = opnum[0];
         }
         else if (operandTyp[1] == OT_MEMGLOB) {
 
-            strcpy(opchar[2], baseRegData);
+            opchar[2] = opBaseReg;
             setGenRegister('B', opchar[2]);
-            setDataOffset(27, opnum[1], 12);
+            setDataOffset(FLD_OFS12, opnum[1]);
         }
         else {
             setGenRegister('A', opchar[1]);
-            setBit(10, 1, 1);
+            setField(FLD_INDEX, 1);
         }
         if (opchar[2][0] == 'S') {
             value = getSegRegister(opchar[2]);
             if (value > 0 && value < 4) {
-                setBit(13, value, 2);
+                setField(FLD_SEG, value);
             }
             else {
                 snprintf(errmsg, sizeof(errmsg), "Segmentregister S%d not allowed\n", (int)value);
@@ -1252,18 +1478,18 @@ void genBinInstruction() {
 
         setGenRegister('R', opchar[0]);
         if (operandTyp[1] == OT_VALUE) {
-            setBit(27, opnum[1], 12);
+            setField(FLD_OFS12, opnum[1]);
             value = opnum[0];
         }
         else if (operandTyp[1] == OT_MEMGLOB) {
 
-            strcpy(opchar[2], baseRegData);
+            opchar[2] = opBaseReg;
             setGenRegister('B', opchar[2]);
-            setDataOffset(27, opnum[1], 12);
+            setDataOffset(FLD_OFS12, opnum[1]);
         }
         else {
             setGenRegister('A', opchar[1]);
-            setBit(10, 1, 1);
+            setField(FLD_INDEX, 1);
         }
         setGenRegister('B', opchar[2]);
         break;
@@ -1274,15 +1500,11 @@ void genBinInstruction() {
         break;
     }
 
-    // write instruction in BINList
-    createBINEntry();
-
-    ptr_b->b_type = 1;
-    ptr_b->b_lineNr = lineNr;
-    ptr_b->b_codeAdr = codeAdr;
-    ptr_b->b_binInstr = binInstr;
-    ptr_b->b_bin_status = bin_status;
-    strcpy(ptr_b->b_infotext, infmsg);
+    // write instruction in BIN section
+    int word = addBinWord(FALSE);
+    if (branchSym != NULL) {
+        addBranchFixup(word);
+    }
     numOfInstructions++;
     if (bin_status == B_BINCHILD) {
         codeAdr = codeAdr + 4;
@@ -1318,20 +1540,18 @@ void createBinary() {
 
         // SRCbin = Create_SRCnode(SRC_BIN, buffer, lineNr);
 
-        searchSRC(GlobalSRC, 0);
+        searchSRC();
 
 
-        SRCNode* node = (SRCNode*)malloc(sizeof(SRCNode));
+        SRCNode* node = (SRCNode*)arenaAlloc(&srcArena, sizeof(SRCNode));
 
-        if (node == NULL) {
-            fatalError("malloc failed");
-        }
         node->s_type = SRC_BIN;
         node->s_lineNr = lineNr;
         node->s_binStatus = bin_status;
         node->s_binInstr = binInstr;
         node->s_codeAdr = codeAdr;
-        node->s_text = strdup(infmsg);
+        node->s_text = arenaText(&srcArena, infmsg);
+        node->s_textLen = strlen(infmsg);
         node->children = NULL;
         node->s_childCount = 0;
         SRCbin = node;
@@ -1340,7 +1560,7 @@ void createBinary() {
     }
     else {
         bin_status = B_BIN;
-        insertBinToSRC(GlobalSRC, 0);
+        insertBinToSRC();
     }
 
     return;
@@ -1348,85 +1568,27 @@ void createBinary() {
 }
 
 // --------------------------------------------------------------------------------
-//  BIN List Management
+//  BIN Section Management
 // --------------------------------------------------------------------------------
 
-/// \brief Create a new BIN list entry.
-/// \details
-/// Adds a new node to the global BIN list.  
-/// If the list is empty, the first node is allocated and set as `start_b`.  
-/// If the list already exists, the new node is appended at the end.
-void createBINEntry() {
-    if (start_b == NULL) {  // Insert first element
-        start_b = (struct BINList*)malloc(sizeof(struct BINList));
-
-        if (start_b == NULL) {
-
-            fatalError("malloc failed");
-        }
-        start_b->next = NULL;
-        ptr_b = start_b;
-    }
-    else {  // At least one element already exists
-
-        ptr_b = start_b;
-        while (ptr_b->next != NULL) {
-
-            ptr_b = ptr_b->next;
-        }
-
-        ptr_b->next = (struct BINList*)malloc(sizeof(struct BINList));
-        if (ptr_b->next == NULL) {
-
-            printf("Memory allocation failed for BIN List\n");
-            return;
-        }
-        ptr_b = ptr_b->next;
-        ptr_b->next = NULL;
-    }
-}
-
-/// \brief process BIN list 
+/// \brief process BIN sections
 /// \details
-/// reads bin list and creates ELF structure and content and SRC output.  
+/// reads the BIN sections and creates ELF structure and content and SRC output.
+/// The source line of each word is taken from the instruction records, its
+/// code address is counted the way the codegen assigned it (an inserted
+/// ADDIL takes the address in front of its instruction, which then
+/// advances the address by 8).
 void processBIN() {
 
-    ptr_b = start_b;
-
-    while (ptr_b != NULL) {
-    
-        // process instructions
-        if (ptr_b->b_type == 1) {
-            binInstr = ptr_b->b_binInstr;
-            lineNr = ptr_b->b_lineNr;
-            codeAdr = ptr_b->b_codeAdr;
-            bin_status = ptr_b->b_bin_status;
-            if (bin_status == B_BINCHILD) {
-
-                strcpy(infmsg, ptr_b->b_infotext);
-            }
-            
-
-            /// insert Binary in SRC output
-            createBinary();
-
-            /// append binary in ELF code section
-            elfCode[0] = (binInstr >> 24) & 0xFF;
-            elfCode[1] = (binInstr >> 16) & 0xFF;
-            elfCode[2] = (binInstr >> 8) & 0xFF;
-            elfCode[3] = binInstr & 0xFF;
-            addTextSectionData();
-            numOfInstructions++;
-            bin_status = B_BIN;
-
-        }
+    for (int s = 0; s < binCount; s++) {
+        struct BINSection* sec = &binTab[s];
 
         // process CODE Sections
-        if (ptr_b->b_type == 2) {
-            elfCodeAddr = ptr_b->b_addr;
+        if (sec->b_header) {
+            elfCodeAddr = sec->b_addr;
             createTextSegment();
             strcpy(buffer, ".text.");
-            strcat(buffer, ptr_b->b_name);
+            strcat(buffer, internText(sec->b_nameId));
             createTextSection(buffer);
             addTextSectionToSegment();
             // update number of instructions in old segment
@@ -1440,236 +1602,377 @@ void processBIN() {
             }
             
             // add textsegment address to segment table
-            addSegmentEntry(numSegment, ptr_b->b_name, 'T', ptr_b->b_addr, -1);
-            strcpy(currentSegment, ptr_b->b_name);
+            addSegmentEntry(numSegment, internText(sec->b_nameId), 'T', sec->b_addr, -1);
+            strcpy(currentSegment, internText(sec->b_nameId));
             numSegment++;
 
             numOfInstructions = 0;
         }
 
-        if (ptr_b != NULL) {
-            ptr_b = ptr_b->next;
+        // process instructions
+        const struct instrRecord* r = &instrTab[sec->b_firstRecord];
+        const struct BINNote* note = sec->b_notes;
+        const struct BINNote* noteEnd = sec->b_notes + sec->b_noteCount;
+        int adr = sec->b_codeAdr;
+        bool expanded = FALSE;
+
+        for (int i = 0; i < sec->b_count; i++) {
+            bool addil = FALSE;
+            binInstr = sec->b_code[i];
+            lineNr = r->r_lineNr;
+            bin_status = B_BIN;
+            if (note < noteEnd && note->n_index == i) {
+                bin_status = B_BINCHILD;
+                addil = note->n_addil;
+                strcpy(infmsg, note->n_infotext);
+                note++;
+            }
+
+            if (!expanded) {
+                adr = adr + 4;
+            }
+            if (addil) {
+                codeAdr = adr - 4;
+                expanded = TRUE;
+            }
+            else {
+                codeAdr = adr;
+                if (bin_status == B_BINCHILD) {
+                    adr = adr + 4;
+                }
+                expanded = FALSE;
+                r++;
+            }
+
+            /// insert Binary in SRC output
+            createBinary();
+        }
+        bin_status = B_BIN;
+
+        /// append the section to the ELF code section
+        if (sec->b_count > 0) {
+            addTextSectionCode(sec->b_code, sec->b_count);
         }
+        numOfInstructions += sec->b_count;
     }
 }
 
-/// \brief delete BIN list 
+/// \brief delete BIN sections
 /// \details
-/// deletes entire bin list.
+/// frees the instruction words and notes of all sections.
 void deleteBIN() {
- 
-    struct BINList* curr = start_b;
-    struct BINList* next;
 
-    while (curr != NULL) {
-        next = curr->next;  // Save pointer to next node
-        free(curr);         // Free current node
-        curr = next;        // Move to next node
+    for (int s = 0; s < binCount; s++) {
+        free(binTab[s].b_code);
+        free(binTab[s].b_notes);
     }
+    free(binTab);
+    binTab = NULL;
+    binCount = 0;
+    binCapacity = 0;
+}
 
-
-
+/// \brief Free the code generator tables of the current assembly.
+/// \details
+/// Releases the BIN sections and branch fixups that are still pending when an
+/// assembly is abandoned.
+void releaseCodegen() {
+    free(fixupTab);
+    fixupTab = NULL;
+    fixupCount = 0;
+    fixupCapacity = 0;
+    deleteBIN();
 }
 
 
 
 // ============================================================================
-// AST Processing
+// Instruction Processing
 // ============================================================================
 
-/// \brief Traverse and process the abstract syntax tree (AST).
+/// \brief Settle the layout of a new code section.
+/// \param r Record of the `.CODE` directive.
+/// \param labelId Most recent label, names the section if the directive has none.
+/// \param j Job of the section.
 /// \details
-/// Recursively visits AST nodes, extracts instruction data, manages
-/// scope information, and triggers binary generation for instructions.
-/// 
-/// \param node  Pointer to the current AST node.
-/// \param depth Current traversal depth (used for recursion).
-
-void processAST(ASTNode* node, int depth) {
-
-
-    if (!node) return;
+/// Applies the ADDR, ALIGN and ENTRY attributes and names the section that
+/// processBIN() turns into an ELF text section.
+static void genCodeSection(const struct instrRecord* r, uint32_t labelId, struct codeJob* j) {
+    if (r->r_flags & CODE_ENTRY_PREV) {
+        elfEntryPoint = elfCodeAddr;
+    }
+    if (r->r_flags & CODE_ADDR) {
+        elfCodeAddr = r->r_addr;
+    }
+    if (r->r_flags & CODE_ALIGN) {
+        elfCodeAlign = r->r_align;
+    }
+    if (r->r_flags & CODE_ENTRY) {
+        elfEntryPoint = elfCodeAddr;
+    }
 
-    strcpy(currentScopeName, node->a_scopeName);
-    currentScopeLevel = node->a_scopeLevel;
+    j->j_header = TRUE;
+    j->j_nameId = (r->r_labelId != 0) ? r->r_labelId : labelId;
+    j->j_addr = elfCodeAddr;
+    j->j_codeAdr = elfCodeAddr;
 
-    SymNode* currentSym = node->symNodeAdr;
-    
-    AST_numInstr = node->a_numInstr;
+    elfCodeAddrOld = elfCodeAddr;
+    codeExist = TRUE;
+}
 
-    // printf("Nodetype %d Linener %d\n", node->type, node->lineNr);
-    switch (node->a_type) {
+/// \brief Encode the instructions of one code section.
+/// \details
+/// Runs on the calling thread or on a worker thread. Each instruction
+/// record is staged into the (thread-local) globals read by genBinOption()
+/// and genBinInstruction(); the scratch globals they leave behind are reset
+/// as well, so the encoding of a record never depends on the records the
+/// thread encoded before. The record is then encoded right away into the
+/// BIN section of the job. The branch fixups of the thread are handed over
+/// to the job.
+static void encodeCodeJob(struct codeJob* j) {
+    curJob = j;
+    errorSink = deferError;
+    codeAdr = j->j_codeAdr;
+    bin_status = j->j_binStatus;
+    numOfInstructions = 0;
+    addInstrGlob = FALSE;
+
+    int n = j->j_first;
+    struct BINSection* sec = &j->j_section;
+    sec->b_codeAdr = j->j_codeAdr;
+    if (j->j_header) {
+        sec->b_header = TRUE;
+        sec->b_lineNr = j->j_instr[n].r_lineNr;
+        sec->b_nameId = j->j_nameId;
+        sec->b_addr = j->j_addr;
+        n++;
+    }
+    sec->b_firstRecord = n;
 
+    for (; n < j->j_end; n++) {
+        const struct instrRecord* r = &j->j_instr[n];
 
-        case NODE_PROGRAM: 
-        
-            break;
-        
-        case NODE_INSTRUCTION:  
-
-            if (codeInstrFlag == TRUE ) {
-                if (nodeTypeOld == NODE_INSTRUCTION) {
-                    genBinOption();
-                    genBinInstruction();
-                    
-                    
-                }
-                else if (nodeTypeOld == NODE_CODE) {
-
-                    // write code in BINList
-                    createBINEntry();
-                    ptr_b->b_type = 2;
-                    ptr_b->b_lineNr = node->a_lineNr;
-                    strcpy(ptr_b->b_name, label);
-                    ptr_b->b_addr = elfCodeAddr;
-                    ptr_b->b_numOfInstructions = numOfInstructions;
-                    ptr_b->b_entry = elfEntryPoint;
-
-/*
-                    // create ELF structure
-                    createTextSegment();
-                    strcpy(buffer, ".text.");
-                    strcat(buffer, label);
-                    createTextSection(buffer);
-                    addTextSectionToSegment();
-
-                    // add textsegment address to segment table
-                    addSegmentEntry(numSegment, labelCodeOld, 'T', elfCodeAddrOld, numOfInstructions * 4);
-                    numSegment++;
-*/
-                    numOfInstructions = 0;
-                    // codeAdr = 0;
-                    elfCodeAddrOld = elfCodeAddr;
-                    codeAdr = elfCodeAddr;
-                    strcpy(labelCodeOld, label);
-                    codeExist = TRUE;
-                }
+        codeAdr = codeAdr + 4;
+        opCount = r->r_opCount;
+        optCount = r->r_optCount;
+        mode = r->r_mode;
+        opInstrType = r->r_instrType;
+
+        for (int i = 0; i < MAX_INSTR_OPERANDS; i++) {
+            if (i < opCount) {
+                opchar[i] = r->r_op[i];
+                opnum[i] = r->r_opNum[i];
+                opId[i] = r->r_opId[i];
+                opSym[i] = (r->r_opType[i] == OT_LABEL) ? r->r_label : NULL;
+                operandTyp[i] = r->r_opType[i];
             }
-            codeAdr = codeAdr + 4;
-            opCount = 0;
-            optCount = 0;
-            mode = 0;
-
-            for (int i = 0; i < 5; i++) {
-                strcpy(opchar[i], "");
+            else {
+                opchar[i] = "";
                 opnum[i] = 0;
+                opId[i] = 0;
+                opSym[i] = NULL;
+                operandTyp[i] = OT_NOTHING;
             }
-            nodeTypeOld = node->a_type;
-            strcpy(option[0], "");
-            strcpy(option[1], "");
-            currentSymSave = currentSym;
-            binInstr = node->a_valnum;
-            lineNr = node->a_lineNr;
-            if (addInstrLine == TRUE) {
-                node->a_numInstr = 2;
-            }
-            codeInstrFlag = TRUE;
-            break;
-
+        }
+        for (int i = 0; i < MAX_INSTR_OPTIONS; i++) {
+            option[i] = (i < optCount) ? r->r_opt[i] : "";
+        }
+        opBaseReg = r->r_baseReg;
+        instrCodeAdr = r->r_codeAdr;
+        instrSectionId = r->r_sectionId;
+        binInstr = r->r_binInstr;
+        lineNr = r->r_lineNr;
 
-        case NODE_CODE:
+        value = 0;
+        binInstrSave = 0;
+        addInstrLine = FALSE;
+        infmsg[0] = '\0';
+        branchSym = NULL;
+        branchField = NULL;
 
+        genBinOption();
+        genBinInstruction();
+    }
 
-            if (codeInstrFlag == TRUE) {
+    j->j_fixups = fixupTab;
+    j->j_fixupCount = fixupCount;
+    j->j_numOfInstructions = numOfInstructions;
+    j->j_addInstr = addInstrGlob;
+    j->j_codeAdrEnd = codeAdr;
+    j->j_lineNrEnd = lineNr;
+
+    fixupTab = NULL;
+    fixupCount = 0;
+    fixupCapacity = 0;
+    errorSink = NULL;
+    curJob = NULL;
+}
 
-                if (nodeTypeOld == NODE_INSTRUCTION) {
+/// \brief Free what a job still owns.
+static void freeCodeJob(struct codeJob* j) {
+    free(j->j_section.b_code);
+    free(j->j_section.b_notes);
+    free(j->j_fixups);
+    free(j->j_shifts);
+    free(j->j_errors);
+    arenaRelease(&j->j_text);
+}
 
-                    genBinOption();
-                    genBinInstruction();
-                }
-                else if (nodeTypeOld == NODE_CODE) {
-
-                    // write code in BINList
-                    createBINEntry();
-                    ptr_b->b_type = 2;
-                    ptr_b->b_lineNr = node->a_lineNr;
-                    strcpy(ptr_b->b_name, labelCodeOld);
-                    ptr_b->b_addr = elfCodeAddrOld;
-                    ptr_b->b_numOfInstructions = numOfInstructions;
-                    ptr_b->b_entry = elfEntryPoint;
-
-/*                  
-                    // create ELF structure
-                    createTextSegment();
-                    strcpy(buffer, ".text.");
-                    strcat(buffer, label);
-                    createTextSection(buffer);
-                    addTextSectionToSegment();
-
-                    // add textsegment address to segment table
-                    addSegmentEntry(numSegment, labelCodeOld, 'T', elfCodeAddrOld, numOfInstructions*4);
-                    numSegment++;
-*/
-                    numOfInstructions = 0;
-                    // codeAdr = 0;
-                    elfCodeAddrOld = elfCodeAddr;
-                    codeAdr = elfCodeAddr;
-                    strcpy(labelCodeOld, label);
-                    codeExist = TRUE;
-                }
+/// \brief Join the encoded code sections in source order.
+/// \details
+/// Appends the sections to ::binTab, collects the branch fixups,
+/// enters the ADDIL expansions and reports the error messages, exactly as
+/// if the sections had been encoded one after the other.
+static void joinCodeJobs(struct codeJob* jobs, int numJobs) {
+    for (int k = 0; k < numJobs; k++) {
+        struct codeJob* j = &jobs[k];
+
+        if (binCount == binCapacity) {
+            binCapacity = (binCapacity == 0) ? 16 : binCapacity * 2;
+            binTab = (struct BINSection*)realloc(binTab, sizeof(struct BINSection) * binCapacity);
+            if (binTab == NULL) {
+                fatalError("realloc failed");
             }
+        }
+        binTab[binCount] = j->j_section;
+        memset(&j->j_section, 0, sizeof(struct BINSection));
+        for (int i = 0; i < j->j_fixupCount; i++) {
+            j->j_fixups[i].f_section = binCount;
+        }
+        binCount++;
 
-            nodeTypeOld = node->a_type;
-            codeInstrFlag = TRUE;
-            break;
-        
-        case NODE_ADDR:
-            elfCodeAddr = node->a_valnum;
-
-            break;
-
-        case NODE_ALIGN:
-            elfCodeAlign = node->a_valnum;
-            break;
-
-        case NODE_ENTRY:
-            elfEntryPoint = elfCodeAddr;
-            break;
-
-        case NODE_LABEL: 
-            strcpy(label, node->a_value);
-
-            break;
-
-
-        case NODE_DIRECTIVE:
-            break;
-    
-        case NODE_OPTION: 
-            strcpy(option[optCount], node->a_value);
-            optCount++;
-            break;
-
-        case NODE_OPERATION: 
-            opInstrType = node->a_valnum;
-            break;
-        
-        case NODE_OPERAND: 
-            //printf("Operand %s %d  Opcount %d\n", node->value, node->valnum, opCount);
-            strcpy(opchar[opCount], node->a_value);
-            opnum[opCount] = node->a_valnum;
-            operandTyp[opCount] = node->a_operandType;
-            strcpy(baseRegData, node->a_baseReg);
-            opCount++;
-            break;
-        
-        case NODE_MODE:
-
-            mode = node->a_valnum;
-            // now we can populate the instruction
-            break;
+        if (fixupCount + j->j_fixupCount > fixupCapacity) {
+            fixupCapacity = fixupCount + j->j_fixupCount;
+            fixupTab = (struct branchFixup*)realloc(fixupTab, sizeof(struct branchFixup) * fixupCapacity);
+            if (fixupTab == NULL) {
+                fatalError("realloc failed");
+            }
+        }
+        if (j->j_fixupCount > 0) {
+            memcpy(fixupTab + fixupCount, j->j_fixups, sizeof(struct branchFixup) * j->j_fixupCount);
+            fixupCount += j->j_fixupCount;
+        }
 
-        default:
-            snprintf(errmsg, sizeof(errmsg), "This should not happen!!");
-            processError(errmsg);
+        for (int i = 0; i < j->j_shiftCount; i++) {
+            addCodeShift(j->j_shifts[i].x_sectionId, j->j_shifts[i].x_codeAdr);
+        }
+        for (int i = 0; i < j->j_errorCount; i++) {
+            lineNr = j->j_errors[i].e_lineNr;
+            processError(j->j_errors[i].e_text);
+        }
+        if (j->j_addInstr) {
+            addInstrGlob = TRUE;
+        }
     }
 
-    for (int i = 0; i < node->a_childCount; i++) {
-        processAST(node->children[i], depth + 1);
+    if (numJobs > 0) {
+        numOfInstructions = jobs[numJobs - 1].j_numOfInstructions;
+        codeAdr = jobs[numJobs - 1].j_codeAdrEnd;
+        lineNr = jobs[numJobs - 1].j_lineNrEnd;
     }
 }
 
+/// \brief Generate the binary code of all instruction records.
+/// \details
+/// Splits ::instrTab into code sections, settles their layout, encodes the
+/// sections (in parallel for large programs or on the number of threads
+/// set with -j, in order when DBG_GENBIN traces the encoding) and joins the results into the BIN sections.
+void processInstructions() {
+    uint32_t labelId = internString(label);
+
+    // Split the records into code sections and settle the layout.
+    int numJobs = 0;
+    for (int n = 0; n < instrCount; n++) {
+        if (instrTab[n].r_kind == NODE_CODE || n == 0) {
+            numJobs++;
+        }
+    }
+    struct codeJob* jobs = (struct codeJob*)calloc(numJobs > 0 ? numJobs : 1, sizeof(struct codeJob));
+    if (jobs == NULL) {
+        fatalError("malloc failed");
+    }
 
+    int k = -1;
+    int binStatus = bin_status;
+    for (int n = 0; n < instrCount; n++) {
+        const struct instrRecord* r = &instrTab[n];
+
+        if (r->r_kind == NODE_CODE || n == 0) {
+            k++;
+            jobs[k].j_instr = instrTab;
+            jobs[k].j_first = n;
+            jobs[k].j_codeAdr = codeAdr;
+            jobs[k].j_binStatus = binStatus;
+            if (r->r_kind == NODE_CODE) {
+                genCodeSection(r, labelId, &jobs[k]);
+            }
+        }
+        jobs[k].j_end = n + 1;
+        if (r->r_kind == NODE_CODE) {
+            labelId = (r->r_labelId != 0) ? r->r_labelId : labelId;
+        }
+        else {
+            binStatus = B_BIN;
+            if (r->r_labelId != 0) {
+                labelId = r->r_labelId;
+            }
+        }
+    }
 
+    // Encode the sections.
+    int numThreads = (int)std::thread::hardware_concurrency();
+    if (numThreads < 1 || instrCount < CODEGEN_PAR_MIN || DBG_GENBIN == TRUE) {
+        numThreads = 1;
+    }
+    if (codegenThreads > 0 && DBG_GENBIN == FALSE) {
+        numThreads = codegenThreads;
+    }
+    if (numThreads > numJobs) {
+        numThreads = numJobs;
+    }
 
+    std::exception_ptr failure;
+    std::mutex failureLock;
+    std::atomic<int> nextJob(0);
+    struct interner* names = internTab;
+    auto worker = [&]() {
+        internTab = names;
+        try {
+            int i;
+            while ((i = nextJob++) < numJobs) {
+                encodeCodeJob(&jobs[i]);
+            }
+        }
+        catch (...) {
+            errorSink = NULL;
+            curJob = NULL;
+            std::lock_guard<std::mutex> guard(failureLock);
+            if (!failure) failure = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < numThreads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : pool) {
+        t.join();
+    }
 
+    if (!failure) {
+        try {
+            joinCodeJobs(jobs, numJobs);
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+    }
+    for (int i = 0; i < numJobs; i++) {
+        arenaAdopt(&srcArena, &jobs[i].j_text);
+        freeCodeJob(&jobs[i]);
+    }
+    free(jobs);
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
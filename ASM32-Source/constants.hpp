@@ -38,6 +38,25 @@
 #define MAX_ERROR_LENGTH 255     ///< Maximum length of an error message.
 #define MAX_TOKEN_PER_LINE 20    ///< Maximum number of tokens per source line.
 #define MAX_ENTRIES 255          ///< Max # of entries in segment table
+#define MAX_INSTR_OPERANDS 5     ///< Operands kept in an instruction record.
+#define MAX_INSTR_OPTIONS 2      ///< Options kept in an instruction record.
+#define CODE_ADDR 1              ///< Code record: ADDR given.
+#define CODE_ALIGN 2             ///< Code record: ALIGN given.
+#define CODE_ENTRY 4             ///< Code record: ENTRY given after ADDR.
+#define CODE_ENTRY_PREV 8        ///< Code record: ENTRY given before ADDR.
+
+// -----------------------------------------------------------------------------
+// ELF dump parts
+// -----------------------------------------------------------------------------
+
+/// \brief Parts of the ELF dump, combined in DBG_ELF_PARTS.
+#define ELF_DUMP_HEADER 1        ///< ELF header.
+#define ELF_DUMP_SECTIONS 2      ///< Section headers.
+#define ELF_DUMP_SEGMENTS 4      ///< Program headers.
+#define ELF_DUMP_NOTES 8         ///< Contents of the note sections.
+#define ELF_DUMP_DATA 16         ///< Section contents (hex).
+#define ELF_DUMP_HEADERS (ELF_DUMP_HEADER | ELF_DUMP_SECTIONS | ELF_DUMP_SEGMENTS)
+#define ELF_DUMP_ALL (ELF_DUMP_HEADERS | ELF_DUMP_NOTES | ELF_DUMP_DATA)
 
 // -----------------------------------------------------------------------------
 // File extensions
@@ -275,7 +294,7 @@ typedef enum {
 // -----------------------------------------------------------------------------
 
 /// \brief Table of supported assembler directives.
-const struct directInfo {
+constexpr struct directInfo {
     char directive[12]; ///< Directive name.
     int  directNum;     ///< Associated directive enumeration value.
 } dirCodeTab[] = {
@@ -308,7 +327,7 @@ const struct directInfo {
 // -----------------------------------------------------------------------------
 
 /// \brief Table of reserved words that cannot be used as identifiers.
-const struct reservedInfo {
+constexpr struct reservedInfo {
     char resWord[12]; ///< Reserved word string.
 } resWordTab[] = {
     { "IF" }, { "ELSE" },
@@ -330,7 +349,7 @@ const struct reservedInfo {
 /// - The mnemonic string (e.g., "ADD").
 /// - The 32-bit binary instruction pattern.
 /// - The associated enum value for instruction classification.
-const struct opCodeInfo {
+constexpr struct opCodeInfo {
     char        mnemonic[8]; ///< Instruction mnemonic.
     uint32_t    binInstr;    ///< 32-bit binary instruction encoding.
     int         instrType;   ///< Associated opcode enumeration value.
@@ -412,3 +431,104 @@ const struct opCodeInfo {
     { "XORH",    0x58010000 , XOR },
     { "XORW",    0x58020000 , XOR },
 };
+
+
+// -----------------------------------------------------------------------------
+// Keyword lookup
+// -----------------------------------------------------------------------------
+
+/// \brief Upper-case an ASCII character (usable in constant expressions).
+constexpr char kwUpper(char c) {
+    return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+/// \brief Case-insensitive comparison of a keyword with a word.
+constexpr bool kwEqual(const char* keyword, const char* word) {
+    while (*keyword != '\0' && kwUpper(*word) == *keyword) {
+        keyword++;
+        word++;
+    }
+    return *keyword == '\0' && *word == '\0';
+}
+
+/// \brief Seeded, case-insensitive hash of a word.
+constexpr uint32_t kwHash(const char* word, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (; *word != '\0'; word++) {
+        h = (h ^ (uint8_t)kwUpper(*word)) * 16777619u;
+    }
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+/// \brief Perfect hash over the names of a keyword table.
+/// \details
+/// Built at compile time by buildKeywordHash(): the seed is chosen such that
+/// every keyword of the table lands in its own slot, so a lookup needs one
+/// hash and at most one string comparison.
+template <size_t M>
+struct KeywordHash {
+    uint32_t seed;      ///< Hash seed without collisions.
+    uint8_t  slot[M];   ///< Table index + 1 per slot, 0 = empty.
+};
+
+/// \brief Build the perfect hash for a keyword table with M slots (power of 2).
+template <size_t M, typename T, size_t N, typename F>
+constexpr KeywordHash<M> buildKeywordHash(const T(&tab)[N], F name) {
+    static_assert((M & (M - 1)) == 0 && N < 255 && N < M, "bad keyword hash size");
+    for (uint32_t seed = 1; seed < 100000; seed++) {
+        KeywordHash<M> kh{};
+        kh.seed = seed;
+        bool ok = true;
+        for (size_t i = 0; i < N && ok; i++) {
+            uint32_t h = kwHash(name(tab[i]), seed) & (M - 1);
+            if (kh.slot[h] != 0) {
+                ok = false;
+            }
+            kh.slot[h] = (uint8_t)(i + 1);
+        }
+        if (ok) {
+            return kh;
+        }
+    }
+    throw "no perfect hash seed found";
+}
+
+/// \brief Look up a word in a keyword table via its perfect hash.
+/// \return Index of the matching entry, or -1.
+template <size_t M, typename T, size_t N, typename F>
+constexpr int findKeyword(const KeywordHash<M>& kh, const T(&tab)[N], F name, const char* word) {
+    int i = kh.slot[kwHash(word, kh.seed) & (M - 1)] - 1;
+    return (i >= 0 && kwEqual(name(tab[i]), word)) ? i : -1;
+}
+
+constexpr auto opCodeName = [](const opCodeInfo& e) { return e.mnemonic; };
+constexpr auto dirCodeName = [](const directInfo& e) { return e.directive; };
+constexpr auto resWordName = [](const reservedInfo& e) { return e.resWord; };
+
+constexpr auto opCodeHash = buildKeywordHash<1024>(opCodeTab, opCodeName);
+constexpr auto dirCodeHash = buildKeywordHash<256>(dirCodeTab, dirCodeName);
+constexpr auto resWordHash = buildKeywordHash<256>(resWordTab, resWordName);
+
+/// \brief Find an opcode mnemonic (case-insensitive).
+/// \return Index into opCodeTab, or -1.
+constexpr int findOpCode(const char* word) {
+    return findKeyword(opCodeHash, opCodeTab, opCodeName, word);
+}
+
+/// \brief Find a directive name (case-insensitive).
+/// \return Index into dirCodeTab, or -1.
+constexpr int findDirective(const char* word) {
+    return findKeyword(dirCodeHash, dirCodeTab, dirCodeName, word);
+}
+
+/// \brief Find a reserved word (case-insensitive).
+/// \return Index into resWordTab, or -1.
+constexpr int findResWord(const char* word) {
+    return findKeyword(resWordHash, resWordTab, resWordName, word);
+}
+
+static_assert(findOpCode("ADD") == 0 && findOpCode("xorw") >= 0 && findOpCode("NOP") == -1);
+static_assert(findDirective("EndFunction") >= 0 && findResWord("r16") >= 0);
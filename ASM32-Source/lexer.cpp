@@ -1,59 +1,64 @@
 #include "constants.hpp"
 #include "ASM32.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCAN_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 /// @file
 /// \brief Lexer module for ASM32.
 /// \details
-/// This file implements the lexer, which reads source lines and
-/// produces a linked list of tokens. Tokens represent identifiers,
+/// This file implements the lexer, which scans source lines in the
+/// mapped source file and produces a contiguous stream of tokens. Tokens represent identifiers,
 /// literals, operators, and punctuation that will later be used by
 /// the parser. It includes functions for building the token list,
 /// printing it for debugging, and extracting tokens from the input.
+/// Runs of blanks, identifiers and numbers are measured by SSE2/AVX2
+/// scanners selected at startup, with a table-driven scalar fallback.
+/// Large sources are split into chunks at line boundaries and lexed on
+/// a pool of threads; the lexer state is thread-local.
+/// Rewritten lexemes are kept in an arena per chunk (or stream) and are
+/// released with the assembly by releaseLexer().
 
 
 // --------------------------------------------------------------------------------
-//  Token List Management
+//  Token Stream Management
 // --------------------------------------------------------------------------------
 
-/// \brief Create a new token list entry.
+/// \brief Create a new token stream entry.
 /// \details
-/// Adds a new node to the global token list.  
-/// If the list is empty, the first node is allocated and set as `start_t`.  
-/// If the list already exists, the new node is appended at the end.
+/// Appends an entry to the contiguous token array `tokenTab` and points
+/// `ptr_t` at it. The array doubles its capacity when it is full, so
+/// appending is amortized constant time. `ptr_t` stays valid until the
+/// next call.
 void createTokenEntry() {
-    if (start_t == NULL) {  // Insert first element
-        start_t = (struct tokenList*)malloc(sizeof(struct tokenList));
+    if (tokenCount == tokenCapacity) {
+        tokenCapacity = (tokenCapacity == 0) ? 4096 : tokenCapacity * 2;
+        tokenTab = (struct tokenEntry*)realloc(tokenTab, sizeof(struct tokenEntry) * tokenCapacity);
 
-        if (start_t == NULL) {
+        if (tokenTab == NULL) {
 
-            fatalError("malloc failed");
+            fatalError("realloc failed");
         }
-        start_t->next = NULL;
-        ptr_t = start_t;
-    }
-    else {  // At least one element already exists
-
-        ptr_t = start_t;
-        while (ptr_t->next != NULL) {
-        
-            ptr_t = ptr_t->next;
-        }
-
-        ptr_t->next = (struct tokenList*)malloc(sizeof(struct tokenList));
-        if (ptr_t->next == NULL) {
-            
-            printf("Memory allocation failed for Token List\n");
-            return;
-        }
-        ptr_t = ptr_t->next;
-        ptr_t->next = NULL;
     }
+    ptr_t = &tokenTab[tokenCount++];
 }
 
 /// \brief Print the token list.
 /// \details
 /// If debugging is enabled (`DBG_TOKEN == TRUE`),  
-/// prints the contents of the token list, including line number,
+/// prints the contents of the token stream, including line number,
 /// column, token type, and token string.
 void printTokenList() {
     if (DBG_TOKEN == TRUE) {
@@ -62,32 +67,252 @@ void printTokenList() {
         printf("Line#\tcol\tToktyp\tToken\n");
         printf("---------------------------------------------\n");
 
-        struct tokenList* ptr_t = start_t;
-        while (ptr_t != NULL) {
-            printf("%d\t%d\t", ptr_t->t_lineNr, ptr_t->t_column);
-            printTokenCode(ptr_t->t_tokTyp);
-            printf("\t%s\n", ptr_t->t_token);
-            ptr_t = ptr_t->next;
+        for (int i = 0; i < tokenCount; i++) {
+            struct tokenEntry* t = &tokenTab[i];
+            printf("%d\t%d\t", t->t_lineNr, t->t_column);
+            printTokenCode(t->t_tokTyp);
+            printf("\t%.*s\n", t->t_length, t->t_text);
         }
     }
 }
 
+/// \brief Copy the text of a token into a null-terminated buffer.
+/// \param t   Token stream entry.
+/// \param dst Destination buffer of at least `MAX_WORD_LENGTH` bytes.
+/// \details
+/// Token texts are views into the source mapping and are not terminated.
+/// Texts longer than `MAX_WORD_LENGTH - 1` characters are truncated.
+void getTokenText(struct tokenEntry* t, char* dst) {
+    int len = (t->t_length < MAX_WORD_LENGTH) ? t->t_length : MAX_WORD_LENGTH - 1;
+    memcpy(dst, t->t_text, len);
+    dst[len] = '\0';
+}
+
+
+// --------------------------------------------------------------------------------
+//  Character Classification
+// --------------------------------------------------------------------------------
+
+/// \brief Character classes measured by the span scanners.
+enum {
+    CC_BLANK = 1,   ///< Space and tab.
+    CC_IDENT = 2,   ///< Letters, digits, underscore.
+    CC_DEC = 4,     ///< Decimal digits and the digit separator '_'.
+    CC_HEX = 8      ///< Hexadecimal digits and the digit separator '_'.
+};
+
+static unsigned char charClass[256];    ///< Class bits per character (scalar scanner).
+
+/// \brief Span scanners: number of leading characters of a class.
+/// \details
+/// Selected by initScanner(). The text from `p` to `end` must contain a
+/// character outside the class (every source line ends with '\n'); no
+/// byte at or after `end` is read.
+int (*scanBlank)(const char* p, const char* end);
+int (*scanIdent)(const char* p, const char* end);
+int (*scanDec)(const char* p, const char* end);
+int (*scanHex)(const char* p, const char* end);
+
+static int spanScalar(const char* p, int cls) {
+    int n = 0;
+    while (charClass[(unsigned char)p[n]] & cls) {
+        n++;
+    }
+    return n;
+}
+
+static int blankScalar(const char* p, const char*) { return spanScalar(p, CC_BLANK); }
+static int identScalar(const char* p, const char*) { return spanScalar(p, CC_IDENT); }
+static int decScalar(const char* p, const char*) { return spanScalar(p, CC_DEC); }
+static int hexScalar(const char* p, const char*) { return spanScalar(p, CC_HEX); }
+
+#ifdef SCAN_SIMD
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+/// \brief Index of the lowest set bit (mask must not be 0).
+static inline int firstBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (int)i;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// The vector scanners use unaligned loads of whole blocks that lie between
+// the start position and the end of the line, and finish the last partial
+// block with the scalar scanner, so they never read outside the line.
+
+static inline __m128i range16(__m128i x, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(lo - 1)),
+                         _mm_cmplt_epi8(x, _mm_set1_epi8(hi + 1)));
+}
+
+static inline __m128i class16(__m128i x, int cls) {
+    __m128i under = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+    switch (cls) {
+    case CC_BLANK:
+        return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+    case CC_IDENT:
+        return _mm_or_si128(_mm_or_si128(range16(x, 'a', 'z'), range16(x, 'A', 'Z')),
+                            _mm_or_si128(range16(x, '0', '9'), under));
+    case CC_DEC:
+        return _mm_or_si128(range16(x, '0', '9'), under);
+    default:
+        return _mm_or_si128(_mm_or_si128(range16(x, 'a', 'f'), range16(x, 'A', 'F')),
+                            _mm_or_si128(range16(x, '0', '9'), under));
+    }
+}
+
+static inline int span16(const char* p, const char* end, int cls) {
+    const char* blk = p;
+    while (end - blk >= 16) {
+        uint32_t mask = ~(uint32_t)_mm_movemask_epi8(class16(_mm_loadu_si128((const __m128i*)blk), cls)) & 0xFFFFu;
+        if (mask != 0) {
+            return (int)(blk + firstBit(mask) - p);
+        }
+        blk += 16;
+    }
+    return (int)(blk - p) + spanScalar(blk, cls);
+}
+
+static int blankSSE2(const char* p, const char* end) { return span16(p, end, CC_BLANK); }
+static int identSSE2(const char* p, const char* end) { return span16(p, end, CC_IDENT); }
+static int decSSE2(const char* p, const char* end) { return span16(p, end, CC_DEC); }
+static int hexSSE2(const char* p, const char* end) { return span16(p, end, CC_HEX); }
+
+TARGET_AVX2 static inline __m256i range32(__m256i x, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), x));
+}
+
+TARGET_AVX2 static inline __m256i class32(__m256i x, int cls) {
+    __m256i under = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+    switch (cls) {
+    case CC_BLANK:
+        return _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                               _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+    case CC_IDENT:
+        return _mm256_or_si256(_mm256_or_si256(range32(x, 'a', 'z'), range32(x, 'A', 'Z')),
+                               _mm256_or_si256(range32(x, '0', '9'), under));
+    case CC_DEC:
+        return _mm256_or_si256(range32(x, '0', '9'), under);
+    default:
+        return _mm256_or_si256(_mm256_or_si256(range32(x, 'a', 'f'), range32(x, 'A', 'F')),
+                               _mm256_or_si256(range32(x, '0', '9'), under));
+    }
+}
+
+TARGET_AVX2 static inline int span32(const char* p, const char* end, int cls) {
+    const char* blk = p;
+    while (end - blk >= 32) {
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(class32(_mm256_loadu_si256((const __m256i*)blk), cls));
+        if (mask != 0) {
+            return (int)(blk + firstBit(mask) - p);
+        }
+        blk += 32;
+    }
+    return (int)(blk - p) + span16(blk, end, cls);
+}
+
+TARGET_AVX2 static int blankAVX2(const char* p, const char* end) { return span32(p, end, CC_BLANK); }
+TARGET_AVX2 static int identAVX2(const char* p, const char* end) { return span32(p, end, CC_IDENT); }
+TARGET_AVX2 static int decAVX2(const char* p, const char* end) { return span32(p, end, CC_DEC); }
+TARGET_AVX2 static int hexAVX2(const char* p, const char* end) { return span32(p, end, CC_HEX); }
+
+/// \brief Check whether the CPU and the operating system support AVX2.
+static bool cpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return FALSE;
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0) return FALSE;          // OSXSAVE
+    if ((_xgetbv(0) & 6) != 6) return FALSE;                // XMM and YMM state
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+/// \brief Fill the character class table and select the span scanners.
+static void selectScanners() {
+    for (int ch = 0; ch < 256; ch++) {
+        unsigned char cls = 0;
+        if (ch == ' ' || ch == '\t') cls |= CC_BLANK;
+        if (isalpha(ch) || isdigit(ch) || ch == '_') cls |= CC_IDENT;
+        if (isdigit(ch) || ch == '_') cls |= CC_DEC;
+        if (isxdigit(ch) || ch == '_') cls |= CC_HEX;
+        charClass[ch] = cls;
+    }
+
+    scanBlank = blankScalar;
+    scanIdent = identScalar;
+    scanDec = decScalar;
+    scanHex = hexScalar;
+
+#ifdef SCAN_SIMD
+    if (cpuHasAVX2()) {
+        scanBlank = blankAVX2;
+        scanIdent = identAVX2;
+        scanDec = decAVX2;
+        scanHex = hexAVX2;
+    }
+    else {
+        scanBlank = blankSSE2;
+        scanIdent = identSSE2;
+        scanDec = decSSE2;
+        scanHex = hexSSE2;
+    }
+#endif
+}
+
+/// \brief Initialize the character class table and select the span scanners.
+/// \details
+/// Uses AVX2 when the CPU supports it, SSE2 on other x86-64 CPUs and the
+/// table-driven scalar scanner everywhere else. The tables are shared by
+/// all assemblies and are set up by the first call.
+void initScanner() {
+    static std::once_flag once;
+    std::call_once(once, selectScanners);
+}
+
 
 // --------------------------------------------------------------------------------
 //  Token Extraction
 // --------------------------------------------------------------------------------
 
+static thread_local struct arena* lexText = NULL;   ///< Rewritten lexemes of the text being lexed.
+static thread_local const char* slEnd = NULL;       ///< End of the current line `sl` (after its '\n').
+
 /// \brief Extract the next token from the current line.
 /// \details
-/// Reads characters from the global source buffer (`sl`) starting
-/// at index `ind`, classifies them, and builds the next token string.
-/// The token type is stored in `tokTyp`, and the token text in `token`.
+/// Reads characters from the current source line (`sl`, a view into the
+/// mapped source file that always ends with `\n`) starting at index `ind`,
+/// and classifies them. The token type is stored in `tokTyp`; the token
+/// text is returned as a view (`tokText`, `tokLen`) without copying.
+/// Numbers (including `L%`/`R%`) are evaluated once into `numToken`, which
+/// is carried in the token; only lexemes with digit separators get a
+/// rewritten copy in the arena of the chunk being lexed. Blank runs, identifiers and
+/// numbers are measured with the span scanners selected by initScanner();
+/// comments need no scanning because the line ends at the first `;`.
 ///
 /// Recognized token types include:
 /// - End of line (`\n`, `;`)
 /// - Punctuation (`. , : ( )`)
 /// - Operators (`+ - * / ~ % | & ^`)
-/// - Identifiers (letters, digits, underscores)
+/// - Identifiers (letters, digits, underscores), interned into `tokId`
 /// - Numbers (decimal, hexadecimal, binary-like with underscores)
 /// - Special forms (`L%<num>`, `R%<num>`)
 ///
@@ -95,51 +320,57 @@ void printTokenList() {
 /// following the token.
 void createToken() {
     int ch;                     ///< Current character under inspection.
-    strcpy(token, "\0");        ///< Reset token buffer.
-    int j = 0;                  ///< Token character index.
+    char num[MAX_WORD_LENGTH];  ///< Rewritten numeric lexeme.
+    int j = 0;                  ///< Numeric lexeme character index.
+    int start;                  ///< Start index of a multi-character token.
+    int len;                    ///< Length of a scanned character run.
     tokTyp = NONE;              ///< Default token type.
-    uint32_t n;
-    char* endptr;
+    uint64_t n;
 
     while (TRUE) {
         ch = sl[ind];
+        if (ch == ' ' || ch == '\t') {
+            ind += scanBlank(sl + ind, slEnd);
+            ch = sl[ind];
+        }
         column = ind;
+        tokText = sl + ind;     ///< Single-character tokens view the character itself.
+        tokLen = 1;
+        tokId = 0;
+        numToken = 0;
 
         // End of line
         if (ch == '\n' || ch == ';') {
             tokTyp = T_EOL;
-            strcpy(token, "");
+            tokLen = 0;
             break;
         }
         // Punctuation and operators
-        else if (ch == '.') { tokTyp = T_DOT; strcpy(token, "."); break; }
-        else if (ch == ',') { tokTyp = T_COMMA; strcpy(token, ","); break; }
-        else if (ch == '_') { tokTyp = T_UNDERSCORE; strcpy(token, "_"); break; }
-        else if (ch == ':') { tokTyp = T_COLON; strcpy(token, ":"); break; }
-        else if (ch == '-') { tokTyp = T_MINUS; strcpy(token, "-"); break; }
-        else if (ch == '+') { tokTyp = T_PLUS; strcpy(token, "+"); break; }
-        else if (ch == '*') { tokTyp = T_MUL; strcpy(token, "*"); break; }
-        else if (ch == '/') { tokTyp = T_DIV; strcpy(token, "/"); break; }
-        else if (ch == '~') { tokTyp = T_NEG; strcpy(token, "~"); break; }
-        else if (ch == '%') { tokTyp = T_MOD; strcpy(token, "%"); break; }
-        else if (ch == '|') { tokTyp = T_OR; strcpy(token, "|"); break; }
-        else if (ch == '&') { tokTyp = T_AND; strcpy(token, "%"); break; }
-        else if (ch == '^') { tokTyp = T_XOR; strcpy(token, "^"); break; }
-        else if (ch == '(') { tokTyp = T_LPAREN; strcpy(token, "("); break; }
-        else if (ch == ')') { tokTyp = T_RPAREN; strcpy(token, ")"); break; }
-
-        // Quoted string
+        else if (ch == '.') { tokTyp = T_DOT; break; }
+        else if (ch == ',') { tokTyp = T_COMMA; break; }
+        else if (ch == '_') { tokTyp = T_UNDERSCORE; break; }
+        else if (ch == ':') { tokTyp = T_COLON; break; }
+        else if (ch == '-') { tokTyp = T_MINUS; break; }
+        else if (ch == '+') { tokTyp = T_PLUS; break; }
+        else if (ch == '*') { tokTyp = T_MUL; break; }
+        else if (ch == '/') { tokTyp = T_DIV; break; }
+        else if (ch == '~') { tokTyp = T_NEG; break; }
+        else if (ch == '%') { tokTyp = T_MOD; break; }
+        else if (ch == '|') { tokTyp = T_OR; break; }
+        else if (ch == '&') { tokTyp = T_AND; break; }
+        else if (ch == '^') { tokTyp = T_XOR; break; }
+        else if (ch == '(') { tokTyp = T_LPAREN; break; }
+        else if (ch == ')') { tokTyp = T_RPAREN; break; }
+
+        // Quoted string (an unterminated string ends at the end of the line)
         else if (ch == '"') {
-            column = ind;
-            tokTyp = T_IDENTIFIER;
             ind++;
-            ch = sl[ind];
-            while (ch != '"') {
-                token[j++] = ch;
+            start = ind;
+            while (sl[ind] != '"' && sl[ind] != '\n') {
                 ind++;
-                ch = sl[ind];
             }
-            token[j] = '\0';
+            tokText = sl + start;
+            tokLen = ind - start;
             ind++;
             tokTyp = T_EOL;  // After a string, nothing else follows on the line
             break;
@@ -147,85 +378,88 @@ void createToken() {
 
         // Special forms: L% / R%
         else if (ch == 'L' && sl[ind + 1] == '%') {
-            column = ind;
             tokTyp = T_NUM;
+            start = ind;
             ind += 2;
             ch = sl[ind];
+            n = 0;
             while (isdigit(ch)) {
-                token[j++] = ch;
+                n = n * 10 + (ch - '0');
                 ind++;
                 ch = sl[ind];
             }
-            token[j] = '\0';
-            // int32_t n = atoi(token);
             // ??? statt mask ein shift >> 10
-
-            n = (uint32_t) strtoul(token, &endptr, 10);
-            n = n >> 10;
-            snprintf(token, sizeof(token), "%u", n);
+            numToken = (uint32_t)n >> 10;
+            tokLen = ind - start;
             ind--;
             break;
         }
         else if (ch == 'R' && sl[ind + 1] == '%') {
-            column = ind;
             tokTyp = T_NUM;
+            start = ind;
             ind += 2;
             ch = sl[ind];
+            n = 0;
             while (isdigit(ch)) {
-                token[j++] = ch;
+                n = n * 10 + (ch - '0');
                 ind++;
                 ch = sl[ind];
             }
-            token[j] = '\0';
-            n = (uint32_t)strtoul(token, &endptr, 10);
-            n &= 0x3FF;
-            snprintf(token, sizeof(token), "%u", n);
+            numToken = (uint32_t)n & 0x3FF;
+            tokLen = ind - start;
             ind--;
             break;
         }
 
         // Identifier (letters, digits, underscores)
         else if (isalpha(ch)) {
-            column = ind;
             tokTyp = T_IDENTIFIER;
-            while (isalpha(ch) || isdigit(ch) || isunderline(ch)) {
-                token[j++] = ch;
-                ind++;
-                ch = sl[ind];
+            tokLen = scanIdent(sl + ind, slEnd);
+            // Intern the name the way the parser normalizes it (upper case, truncated)
+            len = (tokLen < MAX_WORD_LENGTH - 1) ? tokLen : MAX_WORD_LENGTH - 1;
+            for (int k = 0; k < len; k++) {
+                num[k] = (char)toupper((unsigned char)sl[ind + k]);
             }
-            token[j] = '\0';
-            ind--;
+            tokId = internName(num, len);
+            ind += tokLen - 1;
             break;
         }
 
         // Number literal (decimal or hexadecimal)
         else if (isdigit(ch)) {
-            column = ind;
             tokTyp = T_NUM;
+            start = ind;
             if (ch == '0' && sl[ind + 1] == 'x') {
                 // Hexadecimal literal
-                token[j] = ch;
-                token[j + 1] = sl[ind + 1];
+                num[0] = ch;
+                num[1] = sl[ind + 1];
                 j = 2;
                 ind += 2;
-                ch = sl[ind];
-                while (isxdigit(ch) || isunderline(ch)) {
-                    if (ch != '_') token[j++] = ch;
-                    ind++;
-                    ch = sl[ind];
-                }
+                len = scanHex(sl + ind, slEnd);
             }
             else {
                 // Decimal literal
-                while (isdigit(ch) || isunderline(ch)) {
-                    if (ch != '_') token[j++] = ch;
-                    ind++;
-                    ch = sl[ind];
+                len = scanDec(sl + ind, slEnd);
+            }
+            // Copy the digits, dropping digit separators
+            if (j + len < MAX_WORD_LENGTH && memchr(sl + ind, '_', len) == NULL) {
+                memcpy(num + j, sl + ind, len);
+                j += len;
+            }
+            else {
+                for (int k = 0; k < len; k++) {
+                    if (sl[ind + k] != '_' && j < MAX_WORD_LENGTH - 1) num[j++] = sl[ind + k];
                 }
             }
-            token[j] = '\0';
+            ind += len;
+            num[j] = '\0';
+            // Only lexemes with digit separators need a rewritten copy.
+            tokLen = j;
+            if (j != ind - start) {
+                tokText = arenaText(lexText, num);
+            }
             ind--;
-            numToken = (int)strtol(token, NULL, 0);
+            numToken = (int64_t)strtoll(num, NULL, 0);
             break;
         }
 
@@ -233,3 +467,497 @@ void createToken() {
     }
     ind++;
 }
+
+
+// --------------------------------------------------------------------------------
+//  Source Lexing
+// --------------------------------------------------------------------------------
+
+#define LEX_CHUNK_MIN (1 << 20)         ///< Smallest chunk worth a thread (bytes).
+#define LEX_CHUNKS_PER_THREAD 4         ///< Chunks per thread, for load balancing.
+#define TOKEN_RING_SIZE (1 << 16)       ///< Token ring capacity in streaming mode (power of 2).
+#define LINE_RING_SIZE (1 << 14)        ///< Line ring capacity in streaming mode (power of 2).
+#define STREAM_SPIN 64                  ///< Polls of a ring before a streaming thread blocks.
+
+/// \brief Source line produced by lexing a chunk.
+struct lexLine {
+    size_t l_offset;                    ///< Offset of the line from the start of the lexed text.
+    int l_len;                          ///< Length of the line without '\n'.
+};
+
+/// \brief Tokens and source lines of one chunk of the source file.
+/// \details
+/// A chunk starts at the beginning of a line and ends after a newline or at
+/// the end of the file. Token line numbers are relative to the chunk (its
+/// first line is 1) until the chunks are joined.
+struct lexChunk {
+    const char* c_begin;                ///< First byte of the chunk.
+    const char* c_end;                  ///< End of the chunk (exclusive).
+    struct tokenEntry* c_tokens;        ///< Tokens of the chunk.
+    int c_tokenCount;                   ///< Number of tokens.
+    int c_tokenCapacity;                ///< Allocated entries in c_tokens.
+    struct lexLine* c_lines;            ///< Source lines of the chunk.
+    int c_lineCount;                    ///< Number of lines.
+    int c_lineCapacity;                 ///< Allocated entries in c_lines.
+    struct arena c_text;                ///< Rewritten lexemes of the chunk.
+};
+
+/// \brief Rings shared by the parser and the lexer thread in streaming mode.
+/// \details
+/// Belongs to the assembly running on the parser's thread; the lexer thread
+/// works on it through a pointer (see startTokenStream()).
+struct tokenStream {
+    struct tokenEntry* s_tokens;        ///< Bounded token ring.
+    struct lexLine* s_lines;            ///< Bounded source line ring.
+    std::atomic<int> s_tokenHead;       ///< Tokens published by the lexer thread.
+    std::atomic<int> s_tokenTail;       ///< Tokens released by the parser.
+    std::atomic<int> s_lineHead;        ///< Lines published by the lexer thread.
+    std::atomic<int> s_lineTail;        ///< Lines taken over by the parser.
+    std::atomic<bool> s_done;           ///< Lexer thread has finished (EOF token published or failed).
+    std::atomic<bool> s_stop;           ///< Assembly was abandoned, the lexer thread has to return.
+    std::exception_ptr s_error;         ///< Fatal error of the lexer thread.
+    std::mutex s_lock;                  ///< Guards blocking on s_wake.
+    std::condition_variable s_wake;     ///< Signalled when either side made progress.
+    std::atomic<int> s_sleepers;        ///< Threads blocked (or about to block) on s_wake.
+    struct arena s_text;                ///< Rewritten lexemes.
+    int s_linesTaken;                   ///< Source lines added to the SRC tree.
+    std::thread s_thread;               ///< Lexer thread.
+};
+
+static thread_local struct tokenStream stream;      ///< Token stream of the assembly on this thread.
+static thread_local struct arena lexArena = {};     ///< Rewritten lexemes of the joined chunks.
+
+/// \brief Wake the other side of the stream if it is blocked.
+/// \details
+/// Called after publishing progress (ring head or tail, done, stop). The
+/// fence pairs with the one in waitStream(): either the blocked thread
+/// sees the progress when it checks, or this thread sees it sleeping.
+static void wakeStream(struct tokenStream* s) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (s->s_sleepers.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> guard(s->s_lock);
+        s->s_wake.notify_all();
+    }
+}
+
+/// \brief Wait until a condition on the stream holds.
+/// \param ready Condition, checked on the atomics of the stream.
+/// \details
+/// Polls briefly, then blocks on the stream's condition variable, so a
+/// stalled side does not keep a core busy.
+template <typename Ready>
+static void waitStream(struct tokenStream* s, Ready ready) {
+    for (int i = 0; i < STREAM_SPIN; i++) {
+        if (ready()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(s->s_lock);
+    s->s_sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    s->s_wake.wait(lock, ready);
+    s->s_sleepers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/// \brief Wait until a streaming ring has room for one more entry.
+/// \return FALSE if the assembly was abandoned in the meantime.
+static bool waitRing(struct tokenStream* s, int head, std::atomic<int>& tail, int size) {
+    waitStream(s, [&]() {
+        return head - tail.load(std::memory_order_acquire) < size || s->s_stop.load(std::memory_order_relaxed);
+    });
+    return !s->s_stop.load(std::memory_order_relaxed);
+}
+
+/// \brief Tokenize the lines of a chunk or of the token stream.
+/// \param begin First byte (start of a line).
+/// \param end   End of the text (exclusive, after a newline or end of file).
+/// \param c     Chunk whose buffers are filled, or NULL to publish lines
+///              and tokens to the stream.
+/// \param s     Stream to publish to if `c` is NULL.
+/// \details
+/// Runs on a worker thread. Only thread-local lexer state, the chunk or the
+/// stream and the (locked) interner of the assembly are used; line offsets
+/// are relative to `begin`.
+static void lexLines(const char* begin, const char* end, struct lexChunk* c, struct tokenStream* s) {
+    const char* srcPos = begin;
+    int line = 1;
+
+    lexText = (c != NULL) ? &c->c_text : &s->s_text;
+
+    while (srcPos < end) {
+
+        ind = 0;
+        tokTyp = NONE;
+
+        // Find the end of the line. The lexer relies on every line ending
+        // with '\n', so a last line without one gets a terminated copy.
+        const char* eol = (const char*)memchr(srcPos, '\n', end - srcPos);
+        size_t lineOffset = (size_t)(srcPos - begin);
+        int lineLen;
+        if (eol != NULL) {
+            lineLen = (int)(eol - srcPos) + 1;
+            sl = srcPos;
+        }
+        else {
+            lineLen = (int)(end - srcPos);
+            char* last = (char*)arenaAlloc(lexText, lineLen + 2);
+            memcpy(last, srcPos, lineLen);
+            last[lineLen++] = '\n';
+            last[lineLen] = '\0';
+            sl = last;
+        }
+        srcPos += (eol != NULL) ? lineLen : lineLen - 1;
+        slEnd = sl + lineLen;
+
+        struct lexLine* l;
+        if (c != NULL) {
+            if (c->c_lineCount == c->c_lineCapacity) {
+                c->c_lineCapacity = (c->c_lineCapacity == 0) ? 1024 : c->c_lineCapacity * 2;
+                c->c_lines = (struct lexLine*)realloc(c->c_lines, sizeof(struct lexLine) * c->c_lineCapacity);
+                if (c->c_lines == NULL) {
+                    fatalError("realloc failed");
+                }
+            }
+            l = &c->c_lines[c->c_lineCount++];
+        }
+        else {
+            int head = s->s_lineHead.load(std::memory_order_relaxed);
+            if (!waitRing(s, head, s->s_lineTail, LINE_RING_SIZE)) {
+                return;
+            }
+            l = &s->s_lines[head & (LINE_RING_SIZE - 1)];
+        }
+        l->l_offset = lineOffset;
+        l->l_len = lineLen - 1;
+        if (c == NULL) {
+            s->s_lineHead.fetch_add(1, std::memory_order_release);
+            wakeStream(s);
+        }
+
+        // Tokenize the current line.
+        while (tokTyp != T_EOL) {
+            createToken();
+            struct tokenEntry* t;
+            int head = 0;
+            if (c != NULL) {
+                if (c->c_tokenCount == c->c_tokenCapacity) {
+                    c->c_tokenCapacity = (c->c_tokenCapacity == 0) ? 4096 : c->c_tokenCapacity * 2;
+                    c->c_tokens = (struct tokenEntry*)realloc(c->c_tokens, sizeof(struct tokenEntry) * c->c_tokenCapacity);
+                    if (c->c_tokens == NULL) {
+                        fatalError("realloc failed");
+                    }
+                }
+                t = &c->c_tokens[c->c_tokenCount++];
+            }
+            else {
+                head = s->s_tokenHead.load(std::memory_order_relaxed);
+                if (!waitRing(s, head, s->s_tokenTail, TOKEN_RING_SIZE)) {
+                    return;
+                }
+                t = &s->s_tokens[head & (TOKEN_RING_SIZE - 1)];
+            }
+            t->t_lineNr = line;
+            t->t_column = column + 1;
+            t->t_text = tokText;
+            t->t_length = (tokLen < 0xFFFF) ? tokLen : 0xFFFF;
+            t->t_tokTyp = tokTyp;
+            t->t_id = tokId;
+            t->t_value = numToken;
+            if (c == NULL) {
+                s->s_tokenHead.store(head + 1, std::memory_order_release);
+                wakeStream(s);
+            }
+        }
+
+        line++;
+    }
+
+    if (c == NULL) {
+        // Append explicit end-of-input token.
+        int head = s->s_tokenHead.load(std::memory_order_relaxed);
+        if (!waitRing(s, head, s->s_tokenTail, TOKEN_RING_SIZE)) {
+            return;
+        }
+        struct tokenEntry* t = &s->s_tokens[head & (TOKEN_RING_SIZE - 1)];
+        t->t_lineNr = line;
+        t->t_column = 0;
+        t->t_text = "";
+        t->t_length = 0;
+        t->t_tokTyp = EOF;
+        t->t_id = 0;
+        t->t_value = 0;
+        s->s_tokenHead.store(head + 1, std::memory_order_release);
+        wakeStream(s);
+    }
+}
+
+/// \brief Tokenize the whole source file.
+/// \details
+/// The mapped source is split into chunks at line boundaries. Small files
+/// are lexed as a single chunk on the calling thread; larger files are
+/// lexed on a pool of threads that take chunks from a shared counter.
+/// The chunks are then joined in order: source lines are added to the SRC
+/// tree, tokens are appended to `tokenTab` with their line numbers fixed
+/// up, and an EOF token terminates the stream. On return `lineNr` is one
+/// past the last source line. A fatal error on a lexer thread is passed
+/// on to the calling thread once all threads have finished.
+void lexSourceFile() {
+    int numThreads = (int)std::thread::hardware_concurrency();
+    if (numThreads < 1) numThreads = 1;
+
+    size_t numChunks = srcLen / LEX_CHUNK_MIN;
+    if (numChunks > (size_t)numThreads * LEX_CHUNKS_PER_THREAD) numChunks = (size_t)numThreads * LEX_CHUNKS_PER_THREAD;
+    if (numChunks < 1 || numThreads == 1) numChunks = 1;
+
+    struct lexChunk* chunks = (struct lexChunk*)calloc(numChunks, sizeof(struct lexChunk));
+    if (chunks == NULL) {
+        fatalError("malloc failed");
+    }
+
+    // Split the source at line boundaries.
+    const char* srcPos = srcBuf;
+    const char* srcEnd = srcBuf + srcLen;
+    for (size_t i = 0; i < numChunks; i++) {
+        chunks[i].c_begin = srcPos;
+        if (i == numChunks - 1) {
+            chunks[i].c_end = srcEnd;
+        }
+        else {
+            const char* target = srcBuf + srcLen / numChunks * (i + 1);
+            if (target < srcPos) target = srcPos;
+            const char* eol = (const char*)memchr(target, '\n', srcEnd - target);
+            chunks[i].c_end = (eol != NULL) ? eol + 1 : srcEnd;
+        }
+        srcPos = chunks[i].c_end;
+    }
+
+    // Lex the chunks.
+    std::exception_ptr failure;
+    std::mutex failureLock;
+    std::atomic<size_t> nextChunk(0);
+    struct interner* names = internTab;
+    auto worker = [&]() {
+        internTab = names;
+        try {
+            size_t i;
+            while ((i = nextChunk++) < numChunks) {
+                lexLines(chunks[i].c_begin, chunks[i].c_end, &chunks[i], NULL);
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(failureLock);
+            if (!failure) failure = std::current_exception();
+        }
+    };
+    int numWorkers = ((size_t)numThreads < numChunks) ? numThreads : (int)numChunks;
+    std::vector<std::thread> pool;
+    for (int i = 1; i < numWorkers; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+
+    if (failure) {
+        for (size_t i = 0; i < numChunks; i++) {
+            free(chunks[i].c_tokens);
+            free(chunks[i].c_lines);
+            arenaRelease(&chunks[i].c_text);
+        }
+        free(chunks);
+        std::rethrow_exception(failure);
+    }
+
+    // Join the chunks in order.
+    int total = 1;
+    for (size_t i = 0; i < numChunks; i++) {
+        total += chunks[i].c_tokenCount;
+    }
+    if (numChunks == 1 && tokenTab == NULL) {
+        tokenTab = chunks[0].c_tokens;
+        tokenCapacity = chunks[0].c_tokenCapacity;
+    }
+    if (tokenCapacity < total) {
+        tokenCapacity = total;
+        tokenTab = (struct tokenEntry*)realloc(tokenTab, sizeof(struct tokenEntry) * tokenCapacity);
+        if (tokenTab == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+
+    for (size_t i = 0; i < numChunks; i++) {
+        struct lexChunk* c = &chunks[i];
+        size_t chunkOffset = (size_t)(c->c_begin - srcBuf);
+
+        for (int k = 0; k < c->c_lineCount; k++) {
+            SRCsource = createSRCline(chunkOffset + c->c_lines[k].l_offset, c->c_lines[k].l_len, lineNr + k);
+        }
+
+        struct tokenEntry* t = tokenTab + tokenCount;
+        if (c->c_tokens != tokenTab) {
+            memcpy(t, c->c_tokens, sizeof(struct tokenEntry) * c->c_tokenCount);
+            free(c->c_tokens);
+        }
+        for (int k = 0; k < c->c_tokenCount; k++) {
+            t[k].t_lineNr += lineNr - 1;
+        }
+        tokenCount += c->c_tokenCount;
+        lineNr += c->c_lineCount;
+        free(c->c_lines);
+        arenaAdopt(&lexArena, &c->c_text);
+    }
+    free(chunks);
+
+    // Append explicit end-of-input token.
+    createTokenEntry();
+    ptr_t->t_lineNr = lineNr;
+    ptr_t->t_column = 0;
+    ptr_t->t_text = "";
+    ptr_t->t_length = 0;
+    ptr_t->t_tokTyp = EOF;
+    ptr_t->t_id = 0;
+    ptr_t->t_value = 0;
+}
+
+
+// --------------------------------------------------------------------------------
+//  Token Streaming
+// --------------------------------------------------------------------------------
+
+/// \brief Add the streamed source lines up to a line number to the SRC tree.
+/// \details
+/// Lines are published before their tokens, so every line up to the line
+/// of a visible token is already in the line ring.
+static void takeLines(int upToLine) {
+    int taken = stream.s_linesTaken;
+    while (stream.s_linesTaken < upToLine) {
+        int tail = stream.s_lineTail.load(std::memory_order_relaxed);
+        if (tail == stream.s_lineHead.load(std::memory_order_acquire)) {
+            break;
+        }
+        struct lexLine* l = &stream.s_lines[tail & (LINE_RING_SIZE - 1)];
+        stream.s_linesTaken++;
+        SRCsource = createSRCline(l->l_offset, l->l_len, stream.s_linesTaken);
+        stream.s_lineTail.store(tail + 1, std::memory_order_release);
+    }
+    if (stream.s_linesTaken != taken) {
+        wakeStream(&stream);
+    }
+}
+
+/// \brief Body of the lexer thread in streaming mode.
+/// \details
+/// A fatal error is kept in the stream and raised again on the parser's
+/// thread by getToken() or finishTokenStream().
+static void streamLines(struct tokenStream* s, struct interner* names, const char* begin, const char* end) {
+    internTab = names;
+    try {
+        lexLines(begin, end, NULL, s);
+    }
+    catch (...) {
+        s->s_error = std::current_exception();
+    }
+    s->s_done.store(true, std::memory_order_release);
+    wakeStream(s);
+}
+
+/// \brief Start lexing the source file on a separate thread.
+/// \details
+/// Streaming mode: the lexer thread publishes tokens into a bounded ring
+/// buffer while the parser consumes them, so token memory stays constant
+/// and lexing overlaps with parsing. The parser accesses tokens through
+/// hasToken() and getToken(); a token's slot is released as soon as the
+/// parser has moved past it, at the latest after the line's T_EOL.
+void startTokenStream() {
+    stream.s_tokens = (struct tokenEntry*)malloc(sizeof(struct tokenEntry) * TOKEN_RING_SIZE);
+    stream.s_lines = (struct lexLine*)malloc(sizeof(struct lexLine) * LINE_RING_SIZE);
+    if (stream.s_tokens == NULL || stream.s_lines == NULL) {
+        fatalError("malloc failed");
+    }
+    stream.s_tokenHead.store(0);
+    stream.s_tokenTail.store(0);
+    stream.s_lineHead.store(0);
+    stream.s_lineTail.store(0);
+    stream.s_done.store(false);
+    stream.s_stop.store(false);
+    stream.s_sleepers.store(0);
+    stream.s_error = nullptr;
+    stream.s_linesTaken = 0;
+    stream.s_thread = std::thread(streamLines, &stream, internTab, (const char*)srcBuf, (const char*)srcBuf + srcLen);
+}
+
+/// \brief Wait for the lexer thread and add the remaining source lines.
+void finishTokenStream() {
+    stream.s_thread.join();
+    if (stream.s_error) {
+        std::rethrow_exception(stream.s_error);
+    }
+    takeLines(INT32_MAX);
+    free(stream.s_tokens);
+    free(stream.s_lines);
+    stream.s_tokens = NULL;
+    stream.s_lines = NULL;
+    arenaAdopt(&lexArena, &stream.s_text);
+}
+
+/// \brief Free the lexer data of the current assembly.
+/// \details
+/// Stops and joins a lexer thread that is still running (the assembly was
+/// abandoned), then releases the token stream and the rewritten lexemes.
+void releaseLexer() {
+    if (stream.s_thread.joinable()) {
+        stream.s_stop.store(true, std::memory_order_relaxed);
+        wakeStream(&stream);
+        stream.s_thread.join();
+    }
+    free(stream.s_tokens);
+    free(stream.s_lines);
+    stream.s_tokens = NULL;
+    stream.s_lines = NULL;
+    arenaRelease(&stream.s_text);
+
+    free(tokenTab);
+    tokenTab = NULL;
+    tokenCount = tokenCapacity = 0;
+    arenaRelease(&lexArena);
+}
+
+/// \brief Check whether the token stream has a token at an index.
+/// \details
+/// In streaming mode this waits until the lexer thread has published the
+/// token or has reached the end of the input.
+bool hasToken(int index) {
+    if (streamMode == FALSE) {
+        return index < tokenCount;
+    }
+    if (index < stream.s_tokenHead.load(std::memory_order_acquire)) {
+        return TRUE;
+    }
+    waitStream(&stream, [&]() {
+        return index < stream.s_tokenHead.load(std::memory_order_acquire) ||
+            stream.s_done.load(std::memory_order_acquire);
+    });
+    return index < stream.s_tokenHead.load(std::memory_order_acquire);
+}
+
+/// \brief Return the token at an index of the token stream.
+/// \details
+/// In streaming mode all tokens before the index are released to the
+/// lexer thread, and the source lines up to the token's line are added to
+/// the SRC tree. The index must not be smaller than in the previous call.
+/// A fatal error of the lexer thread is raised here.
+struct tokenEntry* getToken(int index) {
+    if (streamMode == FALSE) {
+        return &tokenTab[index];
+    }
+    if (!hasToken(index) && stream.s_error) {
+        std::rethrow_exception(stream.s_error);
+    }
+    stream.s_tokenTail.store(index, std::memory_order_release);
+    wakeStream(&stream);
+    struct tokenEntry* t = &stream.s_tokens[index & (TOKEN_RING_SIZE - 1)];
+    takeLines(t->t_lineNr);
+    return t;
+}
@@ -16,6 +16,16 @@
 // AST Node Management
 // =================================================================================
 
+/// \brief Check if a text has the shape of an identifier.
+/// \details Letter first, then letters, digits or underscores (as lexed).
+static bool isIdentText(const char* text) {
+    if (!isalpha((unsigned char)text[0])) return FALSE;
+    for (int i = 1; text[i] != '\0'; i++) {
+        if (!isalnum((unsigned char)text[i]) && text[i] != '_') return FALSE;
+    }
+    return TRUE;
+}
+
 /// \brief Create a new AST node.
 /// \param type The type of AST node (instruction, identifier, literal, etc.).
 /// \param value String value (identifier name, literal, etc.).
@@ -23,54 +33,122 @@
 /// \return Pointer to the newly allocated ASTNode.
 /// 
 /// Each AST node stores source location, scope, and semantic attributes.
-/// Fatal error if memory allocation fails.
+/// The node and its value text live in ::astArena; only identifiers and the
+/// scope name are interned, literals and base registers are not.
 ASTNode* createASTnode(AST_NodeType type, const char* value, int valnum) {
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    if (node == NULL) {
-        fatalError("malloc failed");
-    }
+    ASTNode* node = (ASTNode*)arenaAlloc(&astArena, sizeof(ASTNode));
     strcpy(currentScopeName, scopeNameTab[currentScopeLevel]);
     node->a_type = type;
-    node->a_value = strdup(value);
     node->a_valnum = valnum;
     node->a_lineNr = lineNr;
     node->a_column = column;
-    node->a_numInstr = 1; 
     node->a_scopeLevel = currentScopeLevel;
-    node->a_scopeName = strdup(currentScopeName);
+    node->a_valueId = isIdentText(value) ? internString(value) : 0;
+    node->a_scopeId = internString(currentScopeName);
+    node->a_value = (value[0] == '\0') ? "" : arenaText(&astArena, value);
+    node->a_scopeName = internText(node->a_scopeId);
+    node->a_codeSectionId = currentCODEId;
     node->symNodeAdr = scopeTab[currentScopeLevel];
+    node->a_symbol = NULL;
     node->children = NULL;
     node->a_codeAdr = codeAdr;
-    node->a_baseReg = strdup(baseRegData);
+    node->a_baseReg = (baseRegData[0] == '\0') ? "" : arenaText(&astArena, baseRegData);
     node->a_operandType = operandType;
     node->a_childCount = 0;
     return node;
 }
 
+// ---------------------------------------------------------------------------------
+// Instruction Records
+//
+// Every instruction and code section node added to the program node gets a
+// record in ::instrTab; the children added to that node fill in the record.
+// Codegen only reads the records.
+// ---------------------------------------------------------------------------------
+
+static thread_local int instrCapacity = 0;           ///< Allocated entries in instrTab.
+
+/// \brief Append the record of an instruction or code section node.
+static void addInstrRecord(ASTNode* node) {
+    if (instrCount == instrCapacity) {
+        instrCapacity = (instrCapacity == 0) ? 1024 : instrCapacity * 2;
+        instrTab = (struct instrRecord*)realloc(instrTab, sizeof(struct instrRecord) * instrCapacity);
+        if (instrTab == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    struct instrRecord* r = &instrTab[instrCount++];
+
+    memset(r, 0, sizeof(struct instrRecord));
+    r->r_kind = (uint8_t)node->a_type;
+    r->r_lineNr = node->a_lineNr;
+    r->r_binInstr = node->a_valnum;
+    r->r_codeAdr = node->a_codeAdr;
+    r->r_sectionId = node->a_codeSectionId;
+    r->r_baseReg = "";
+}
+
+/// \brief Copy a child of an instruction or code section node into its record.
+static void addInstrField(ASTNode* node) {
+    struct instrRecord* r = &instrTab[instrCount - 1];
+
+    switch (node->a_type) {
+    case NODE_LABEL:
+        r->r_labelId = node->a_valueId;
+        break;
+    case NODE_OPERATION:
+        r->r_instrType = node->a_valnum;
+        break;
+    case NODE_OPTION:
+        if (r->r_optCount < MAX_INSTR_OPTIONS) {
+            r->r_opt[r->r_optCount++] = node->a_value;
+        }
+        break;
+    case NODE_OPERAND:
+        if (r->r_opCount < MAX_INSTR_OPERANDS) {
+            r->r_op[r->r_opCount] = node->a_value;
+            r->r_opId[r->r_opCount] = node->a_valueId;
+            r->r_opNum[r->r_opCount] = node->a_valnum;
+            r->r_opType[r->r_opCount] = (uint8_t)node->a_operandType;
+            r->r_opCount++;
+        }
+        r->r_baseReg = node->a_baseReg;
+        break;
+    case NODE_MODE:
+        r->r_mode = node->a_valnum;
+        break;
+    case NODE_ADDR:
+        r->r_addr = node->a_valnum;
+        r->r_flags |= CODE_ADDR;
+        break;
+    case NODE_ALIGN:
+        r->r_align = node->a_valnum;
+        r->r_flags |= CODE_ALIGN;
+        break;
+    case NODE_ENTRY:
+        r->r_flags |= (r->r_flags & CODE_ADDR) ? CODE_ENTRY : CODE_ENTRY_PREV;
+        break;
+    default:
+        break;
+    }
+}
+
 /// \brief Add a child AST node.
 /// \param parent Parent AST node.
 /// \param child Child AST node to attach.
 /// 
-/// Expands the parent's child list dynamically.
-/// Fatal error if memory reallocation fails.
+/// The child list is a span in ::astArena that grows geometrically
+/// (see arenaSpan()). Instructions and code sections are also entered
+/// into ::instrTab.
 void addASTchild(ASTNode* parent, ASTNode* child) {
-    parent->children = (ASTNode**)realloc(parent->children, sizeof(ASTNode*) * (parent->a_childCount + 1));
-    if (parent->children == NULL) {
-        fatalError("realloc failed");
-    }
+    parent->children = (ASTNode**)arenaSpan(&astArena, parent->children, parent->a_childCount, sizeof(ASTNode*));
     parent->children[parent->a_childCount++] = child;
-}
 
-/// \brief Recursively free an AST node and all its children.
-/// \param node Root of the AST subtree to free.
-void freeASTnode(ASTNode* node) {
-    if (node) {
-        free(node->a_value);
-        for (int i = 0; i < node->a_childCount; i++) {
-            freeASTnode(node->children[i]);
-        }
-        free(node->children);
-        free(node);
+    if (parent->a_type == NODE_PROGRAM) {
+        addInstrRecord(child);
+    }
+    else if (parent->a_type == NODE_INSTRUCTION || parent->a_type == NODE_CODE) {
+        addInstrField(child);
     }
 }
 
@@ -87,39 +165,121 @@ void freeASTnode(ASTNode* node) {
 /// \param linenr Source line number.
 /// \return Pointer to the new SymNode.
 SymNode* createSYMnode(SYM_ScopeType type, char* label, char* func, const char* value, int linenr) {
-    SymNode* node = (SymNode*)malloc(sizeof(SymNode));
-    if (node == NULL) {
-        fatalError("malloc failed");
-    }
+    SymNode* node = (SymNode*)arenaAlloc(&symArena, sizeof(SymNode));
     node->y_type = type;
     node->y_scopeLevel = currentScopeLevel;
-    strcpy(node->y_scopeName, currentScopeName);
-    strcpy(node->y_label, label);
-    strcpy(node->y_func, func);
-    strcpy(node->y_value, value);
-    strcpy(node->y_baseReg, dataSegmentBase);
-    strcpy(node->y_currCodeSection, currentCODE);
+    node->y_labelId = internString(label);
+    node->y_scopeId = internString(currentScopeName);
+    node->y_funcId = internString(func);
+    node->y_valueText = (value[0] == '\0') ? "" : arenaText(&symArena, value);
+    node->y_baseRegId = internString(dataSegmentBase);
+    node->y_codeSectionId = currentCODEId;
     node->y_varType = varType;
     node->y_lineNr = lineNr;
     node->y_codeAdr = codeAdr;
     node->y_dataAdr = dataAdr;
+    node->y_value = 0;
     node->children = NULL;
     node->y_childCount = 0;
     return node;
 }
 
+// ---------------------------------------------------------------------------------
+// Symbol Hash Index
+//
+// Every symbol in the tree is also entered into a hash table keyed by its
+// interned label and scope name. Entries with the same key are chained
+// newest first, which is the symbol the tree walk used to end up with.
+// The tree itself is only kept for printSYM() ordering.
+// ---------------------------------------------------------------------------------
+
+/// \brief Hash table entry of one symbol.
+struct symHashEntry {
+    SymNode* h_node;                    ///< Symbol node.
+    uint32_t h_labelId;                 ///< Interned label.
+    uint32_t h_scopeId;                 ///< Interned scope name.
+    int h_next;                         ///< Next entry in the bucket chain, -1 at the end.
+};
+
+static thread_local struct symHashEntry* symHashTab = NULL;  ///< Entries in insertion order.
+static thread_local int symHashCount = 0;                    ///< Number of entries.
+static thread_local int symHashCapacity = 0;                 ///< Allocated entries.
+static thread_local int* symHashHead = NULL;                 ///< First entry per bucket, -1 if empty.
+static thread_local uint32_t symHashSize = 0;                ///< Number of buckets (power of 2).
+
+/// \brief Bucket of a (label, scope) pair.
+static inline uint32_t symHashBucket(uint32_t labelId, uint32_t scopeId) {
+    uint32_t h = labelId * 0x9E3779B1u ^ scopeId * 0x85EBCA77u;
+    return (h ^ (h >> 15)) & (symHashSize - 1);
+}
+
+/// \brief Enter a symbol node into the hash index.
+/// \param node Symbol node that was added to the symbol tree.
+/// 
+/// The table doubles when it is fully loaded; the chains are rebuilt in
+/// insertion order so that newer entries stay in front.
+void addSYMhash(SymNode* node) {
+    if (symHashCount == symHashCapacity) {
+        symHashCapacity = (symHashCapacity == 0) ? 1024 : symHashCapacity * 2;
+        symHashTab = (struct symHashEntry*)realloc(symHashTab, sizeof(struct symHashEntry) * symHashCapacity);
+        if (symHashTab == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    if ((uint32_t)symHashCount >= symHashSize) {
+        symHashSize = (symHashSize == 0) ? 1024 : symHashSize * 2;
+        free(symHashHead);
+        symHashHead = (int*)malloc(sizeof(int) * symHashSize);
+        if (symHashHead == NULL) {
+            fatalError("malloc failed");
+        }
+        memset(symHashHead, 0xFF, sizeof(int) * symHashSize);
+        for (int i = 0; i < symHashCount; i++) {
+            uint32_t b = symHashBucket(symHashTab[i].h_labelId, symHashTab[i].h_scopeId);
+            symHashTab[i].h_next = symHashHead[b];
+            symHashHead[b] = i;
+        }
+    }
+
+    struct symHashEntry* e = &symHashTab[symHashCount];
+    uint32_t b = symHashBucket(node->y_labelId, node->y_scopeId);
+    e->h_node = node;
+    e->h_labelId = node->y_labelId;
+    e->h_scopeId = node->y_scopeId;
+    e->h_next = symHashHead[b];
+    symHashHead[b] = symHashCount++;
+}
+
+/// \brief Look up a symbol by interned label and scope name.
+/// \param labelId Interned label.
+/// \param scopeId Interned scope name.
+/// \param level Scope level searched.
+/// \param exact TRUE: the symbol must be defined at \p level,
+///              FALSE: at \p level or an outer level.
+/// \return The most recently defined matching symbol, or NULL.
+static SymNode* findSYMhash(uint32_t labelId, uint32_t scopeId, int level, bool exact) {
+    if (symHashSize == 0) return NULL;
+
+    for (int i = symHashHead[symHashBucket(labelId, scopeId)]; i >= 0; i = symHashTab[i].h_next) {
+        struct symHashEntry* e = &symHashTab[i];
+        if (e->h_labelId == labelId && e->h_scopeId == scopeId &&
+            (exact ? e->h_node->y_scopeLevel == level : e->h_node->y_scopeLevel <= level)) {
+            return e->h_node;
+        }
+    }
+    return NULL;
+}
+
 /// \brief Add a child symbol node to the symbol table.
 /// \param parent Parent symbol node.
 /// \param child Child symbol node to attach.
 /// 
-/// Expands the parent's child list dynamically.
-/// Fatal error if memory reallocation fails.
+/// Appends the child to the parent's span in ::symArena and enters it into
+/// the hash index.
 void addSYMchild(SymNode* parent, SymNode* child) {
-    parent->children = (SymNode**)realloc(parent->children, sizeof(SymNode*) * (parent->y_childCount + 1));
-    if (parent->children == NULL) {
-        fatalError("realloc failed");
-    }
+    parent->children = (SymNode**)arenaSpan(&symArena, parent->children, parent->y_childCount, sizeof(SymNode*));
     parent->children[parent->y_childCount++] = child;
+    addSYMhash(child);
 }
 
 /// \brief Add a new scope to the symbol table.
@@ -156,48 +316,51 @@ void addDirectiveToScope(SYM_ScopeType type, char* label, char* func, const char
 // Symbol Lookup
 // =================================================================================
 
-/// \brief Search a symbol recursively from the current scope upward.
-/// \param node Current symbol node.
+/// \brief Search a symbol in one level of the scope chain.
 /// \param label Symbol label to search for.
-/// \param depth Recursive depth (for traversal).
 /// 
-/// Updates global variables if a match is found.
-void searchSymAll(SymNode* node, char* label, int depth) {
-    if (!node) return;
-    if (strcmp(node->y_label, label) == 0 &&
-        node->y_scopeLevel <= searchScopeLevel &&
-        strcmp(node->y_scopeName, currentScopeName) == 0) {
-        strcpy(symFunc, node->y_func);
-        strcpy(symValue, node->y_value);
-        strcpy(symDataSegmentBase, node->y_baseReg);
-        dataAdr = node->y_dataAdr;
-        symcodeAdr = node->y_codeAdr;
+/// The level is ::searchScopeLevel with the scope ::currentScopeName (both
+/// set by searchSymbol()); symbols of outer levels in that scope match too.
+/// Updates global variables if a match is found. Label and scope name are
+/// looked up once and the symbol is found through the hash index. A name
+/// that was never interned cannot be in the table.
+void searchSymAll(const char* label) {
+    uint32_t labelId = findName(label);
+    uint32_t scopeId = findName(currentScopeName);
+    if (labelId == 0 || scopeId == 0) return;
+
+    SymNode* sym = findSYMhash(labelId, scopeId, searchScopeLevel, FALSE);
+    if (sym != NULL) {
+        strcpy(symFunc, internText(sym->y_funcId));
+        strcpy(symValue, sym->y_valueText);
+        symNumValue = sym->y_value;
+        strcpy(symDataSegmentBase, internText(sym->y_baseRegId));
+        dataAdr = sym->y_dataAdr;
+        symcodeAdr = getSymCodeAdr(sym);
         symFound = TRUE;
-        return;
-    }
-    for (int i = 0; i < node->y_childCount; i++) {
-        searchSymAll(node->children[i], label, depth + 1);
     }
 }
 
-/// \brief Search for a symbol in the current scope only.
-/// \param node Current symbol node.
-/// \param label Symbol label to search for.
-/// \param depth Recursive depth (for traversal).
-void searchSymLevel(SymNode* node, char* label, int depth) {
-    if (!node) return;
-    if (strcmp(node->y_label, label) == 0 &&
-        node->y_scopeLevel == searchScopeLevel &&
-        strcmp(node->y_scopeName, currentScopeName) == 0) {
-        symcodeAdr = node->y_codeAdr;
+/// \brief Search for a symbol at ::searchScopeLevel only, by interned names.
+/// \param labelId Interned symbol label.
+/// \param scopeId Interned scope name.
+void searchSymLevelId(uint32_t labelId, uint32_t scopeId) {
+    SymNode* sym = findSYMhash(labelId, scopeId, searchScopeLevel, TRUE);
+    if (sym != NULL) {
+        symcodeAdr = getSymCodeAdr(sym);
         symFound = TRUE;
-        return;
-    }
-    for (int i = 0; i < node->y_childCount; i++) {
-        searchSymLevel(node->children[i], label, depth + 1);
     }
 }
 
+/// \brief Search for a symbol at ::searchScopeLevel in ::currentScopeName only.
+/// \param label Symbol label to search for.
+void searchSymLevel(const char* label) {
+    uint32_t labelId = findName(label);
+    uint32_t scopeId = findName(currentScopeName);
+    if (labelId == 0 || scopeId == 0) return;
+    searchSymLevelId(labelId, scopeId);
+}
+
 /// \brief Search for a symbol in the symbol table, moving up through scopes if needed.
 /// \param node Root of the symbol table.
 /// \param label Symbol label.
@@ -207,7 +370,7 @@ bool searchSymbol(SymNode* node, char* label) {
     symFound = FALSE;
 
     while (symFound == FALSE) {
-        searchSymAll(scopeTab[searchScopeLevel], label, 0);
+        searchSymAll(label);
         if (symFound == TRUE) {
             return TRUE;
         }
@@ -218,21 +381,180 @@ bool searchSymbol(SymNode* node, char* label) {
     return symFound;
 }
 
-/// \brief Update symbol table adresses of CODE section
-/// \param node Current symbol node.
+// ---------------------------------------------------------------------------------
+// Label References
+//
+// Label operands of branch instructions are bound to their symbol node
+// while parsing, so that codegen reads the target address from the
+// instruction record instead of searching for it. Forward references are
+// bound once after the whole source has been parsed.
+// ---------------------------------------------------------------------------------
+
+/// \brief Label operand waiting for its label to be defined.
+struct labelRef {
+    ASTNode* l_node;                    ///< Operand node.
+    int l_instr;                        ///< Index of its record in instrTab.
+};
+
+static thread_local struct labelRef* labelRefTab = NULL; ///< Label operands not bound yet.
+static thread_local int labelRefCount = 0;           ///< Number of entries in labelRefTab.
+static thread_local int labelRefCapacity = 0;        ///< Allocated entries in labelRefTab.
+
+/// \brief Bind a label operand to its symbol, or remember it for later.
+/// \param node Operand node naming a label (OT_LABEL), already added to
+///             the current instruction.
+void addLabelRef(ASTNode* node) {
+    node->a_symbol = findSYMhash(node->a_valueId, node->a_scopeId, node->a_scopeLevel, TRUE);
+    instrTab[instrCount - 1].r_label = node->a_symbol;
+    if (node->a_symbol != NULL) return;
+
+    if (labelRefCount == labelRefCapacity) {
+        labelRefCapacity = (labelRefCapacity == 0) ? 256 : labelRefCapacity * 2;
+        labelRefTab = (struct labelRef*)realloc(labelRefTab, sizeof(struct labelRef) * labelRefCapacity);
+        if (labelRefTab == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    labelRefTab[labelRefCount].l_node = node;
+    labelRefTab[labelRefCount].l_instr = instrCount - 1;
+    labelRefCount++;
+}
 
-void updSYM(SymNode* node, int depth) {
-    if (!node) return;
-    if (strcmp(node->y_currCodeSection, currentCODE) == 0) {
-//        if (node->codeAdr >= codeAdr) {
-            node->y_codeAdr = (node->y_codeAdr) + 4;
-//        }
+/// \brief Bind the forward label references after parsing.
+/// 
+/// Operands whose label is still unknown keep a NULL symbol; codegen
+/// reports them as not found.
+void resolveLabelRefs() {
+    for (int i = 0; i < labelRefCount; i++) {
+        ASTNode* node = labelRefTab[i].l_node;
+        node->a_symbol = findSYMhash(node->a_valueId, node->a_scopeId, node->a_scopeLevel, TRUE);
+        instrTab[labelRefTab[i].l_instr].r_label = node->a_symbol;
+    }
+    free(labelRefTab);
+    labelRefTab = NULL;
+    labelRefCount = 0;
+    labelRefCapacity = 0;
+}
+
+// ---------------------------------------------------------------------------------
+// Code Address Shifts
+//
+// When codegen expands an instruction into ADDIL + instruction, everything
+// behind it in the same code section moves by 4 bytes. Symbols keep their
+// original (parse-time) address; the expansions are kept per code section
+// as a sorted list of the original addresses of the expanded instructions,
+// and the final address of a symbol is computed on demand by counting the
+// expansions in front of it.
+// ---------------------------------------------------------------------------------
+
+/// \brief Expanded instructions of one code section.
+struct codeShift {
+    uint32_t c_sectionId;               ///< Interned code section name.
+    uint32_t* c_adr;                    ///< Original addresses, sorted ascending.
+    int c_count;                        ///< Number of expansions.
+    int c_capacity;                     ///< Allocated entries in c_adr.
+};
+
+static thread_local struct codeShift* codeShiftTab = NULL;   ///< One entry per code section with expansions.
+static thread_local int codeShiftCount = 0;                  ///< Number of entries in codeShiftTab.
+
+/// \brief Find the shift list of a code section.
+/// \param sectionId Interned code section name.
+/// \param create TRUE: create the list if the section has none yet.
+/// \return The shift list, or NULL.
+static struct codeShift* findCodeShift(uint32_t sectionId, bool create) {
+    for (int i = 0; i < codeShiftCount; i++) {
+        if (codeShiftTab[i].c_sectionId == sectionId) {
+            return &codeShiftTab[i];
+        }
+    }
+    if (!create) return NULL;
+
+    codeShiftTab = (struct codeShift*)realloc(codeShiftTab, sizeof(struct codeShift) * (codeShiftCount + 1));
+    if (codeShiftTab == NULL) {
+        fatalError("realloc failed");
     }
-    for (int i = 0; i < node->y_childCount; i++) {
-        updSYM(node->children[i], depth + 1);
+    struct codeShift* c = &codeShiftTab[codeShiftCount++];
+    c->c_sectionId = sectionId;
+    c->c_adr = NULL;
+    c->c_count = 0;
+    c->c_capacity = 0;
+    return c;
+}
+
+/// \brief Number of expansions in front of an original address.
+static int countCodeShift(struct codeShift* c, uint32_t adr) {
+    int lo = 0;
+    int hi = c->c_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (c->c_adr[mid] < adr) lo = mid + 1;
+        else hi = mid;
     }
+    return lo;
+}
+
+/// \brief Record that an instruction was expanded by one extra instruction.
+/// \param sectionId Interned name of the code section of the instruction.
+/// \param codeAdr Original (parse-time) address of the instruction.
+/// 
+/// Symbols behind the instruction move by 4 bytes; a label on the
+/// instruction itself stays and addresses the inserted ADDIL.
+void addCodeShift(uint32_t sectionId, uint32_t codeAdr) {
+    struct codeShift* c = findCodeShift(sectionId, TRUE);
+
+    if (c->c_count == c->c_capacity) {
+        c->c_capacity = (c->c_capacity == 0) ? 64 : c->c_capacity * 2;
+        c->c_adr = (uint32_t*)realloc(c->c_adr, sizeof(uint32_t) * c->c_capacity);
+        if (c->c_adr == NULL) {
+            fatalError("realloc failed");
+        }
+    }
+    int pos = countCodeShift(c, codeAdr);
+    memmove(c->c_adr + pos + 1, c->c_adr + pos, sizeof(uint32_t) * (c->c_count - pos));
+    c->c_adr[pos] = codeAdr;
+    c->c_count++;
+}
+
+/// \brief Final code address of a symbol.
+/// \param node Symbol node.
+/// \return The parse-time address plus 4 for every expanded instruction
+///         in front of it in its code section.
+uint32_t getSymCodeAdr(SymNode* node) {
+    struct codeShift* c = findCodeShift(node->y_codeSectionId, FALSE);
+    if (c == NULL) return node->y_codeAdr;
+    return node->y_codeAdr + 4 * countCodeShift(c, node->y_codeAdr);
 }
 
+/// \brief Free the parser tables of the current assembly.
+/// 
+/// Releases the instruction records, the symbol hash index, pending label
+/// references and the code address shifts. Called when the listing has been
+/// printed, or when an assembly is abandoned.
+void releaseParser() {
+    free(instrTab);
+    instrTab = NULL;
+    instrCount = 0;
+    instrCapacity = 0;
+
+    free(symHashTab);
+    free(symHashHead);
+    symHashTab = NULL;
+    symHashHead = NULL;
+    symHashCount = symHashCapacity = 0;
+    symHashSize = 0;
+
+    free(labelRefTab);
+    labelRefTab = NULL;
+    labelRefCount = labelRefCapacity = 0;
+
+    for (int i = 0; i < codeShiftCount; i++) {
+        free(codeShiftTab[i].c_adr);
+    }
+    free(codeShiftTab);
+    codeShiftTab = NULL;
+    codeShiftCount = 0;
+}
 
 
 /// \brief Print the symbol table hierarchy.
@@ -248,38 +570,42 @@ void printSYM(SymNode* node, int depth) {
  
 
     char buffer[9];
+    const char* y_label = internText(node->y_labelId);
+    const char* y_func = internText(node->y_funcId);
+    const char* y_value = node->y_valueText;
+    const char* y_baseReg = internText(node->y_baseRegId);
 
 
     if (node->y_type == SCOPE_PROGRAM) {
-        printf("%-5s %4d                %-8s        %-12s\n", "P", node->y_lineNr,  node->y_label,node->y_value);
+        printf("%-5s %4d                %-8s        %-12s\n", "P", node->y_lineNr,  y_label,y_value);
     }
     if (node->y_type == SCOPE_DIRECT) {
-        if ((strcmp(node->y_func, "REG") == 0) || (strcmp(node->y_func, "EQU") == 0)) {
+        if ((strcmp(y_func, "REG") == 0) || (strcmp(y_func, "EQU") == 0)) {
 
-            printf("%-5s %4d                %-8s %-6s %-12s\n", "D", node->y_lineNr, node->y_label, node->y_func, node->y_value);
+            printf("%-5s %4d                %-8s %-6s %-12s\n", "D", node->y_lineNr, y_label, y_func, y_value);
         }
         snprintf(buffer, sizeof(buffer), "%08X", node->y_dataAdr);
-        if ((strcmp(node->y_func, "BYTE") == 0) ||
-            (strcmp(node->y_func, "HALF") == 0) ||
-            (strcmp(node->y_func, "WORD") == 0) ||
-            (strcmp(node->y_func, "DOUBLE") == 0) ||
-            (strcmp(node->y_func, "BUFFER") == 0)) {
-            printf("%-5s %4d %.4s %.4s  %-3s %-8s %-6s %-16s\n", "D", node->y_lineNr, buffer, buffer + 4, node->y_baseReg, node->y_label, node->y_func, node->y_value);
+        if ((strcmp(y_func, "BYTE") == 0) ||
+            (strcmp(y_func, "HALF") == 0) ||
+            (strcmp(y_func, "WORD") == 0) ||
+            (strcmp(y_func, "DOUBLE") == 0) ||
+            (strcmp(y_func, "BUFFER") == 0)) {
+            printf("%-5s %4d %.4s %.4s  %-3s %-8s %-6s %-16s\n", "D", node->y_lineNr, buffer, buffer + 4, y_baseReg, y_label, y_func, y_value);
         }
-        if ((strcmp(node->y_func, "STRING") == 0)) {
-            printf("%-5s %4d %.4s %.4s  %-3s %-8s %-6s %-16s\n", "D", node->y_lineNr, buffer, buffer + 4, node->y_baseReg, node->y_label, node->y_func, node->y_value);
+        if ((strcmp(y_func, "STRING") == 0)) {
+            printf("%-5s %4d %.4s %.4s  %-3s %-8s %-6s %-16s\n", "D", node->y_lineNr, buffer, buffer + 4, y_baseReg, y_label, y_func, y_value);
         }
 
 
-        if ((strcmp(node->y_func, "CODE") == 0)) {
-            printf("%-5s %4d                %-8s %-6s\n", "D", node->y_lineNr, node->y_label, node->y_func);
+        if ((strcmp(y_func, "CODE") == 0)) {
+            printf("%-5s %4d                %-8s %-6s\n", "D", node->y_lineNr, y_label, y_func);
         }
-        if ((strcmp(node->y_func, "DATA") == 0)) {
-            printf("%-5s %4d            %-3s %-8s %-6s\n", "D", node->y_lineNr, node->y_baseReg,node->y_label, node->y_func);
+        if ((strcmp(y_func, "DATA") == 0)) {
+            printf("%-5s %4d            %-3s %-8s %-6s\n", "D", node->y_lineNr, y_baseReg,y_label, y_func);
         }
-        if ((strcmp(node->y_func, "LABEL") == 0)) {
-            snprintf(buffer, sizeof(buffer), "%08X", node->y_codeAdr);
-            printf("%-5s %4d %.4s %.4s      %-8s %-6s %-12s\n", "D", node->y_lineNr, buffer, buffer + 4, node->y_label, node->y_func, node->y_value);
+        if ((strcmp(y_func, "LABEL") == 0)) {
+            snprintf(buffer, sizeof(buffer), "%08X", getSymCodeAdr(node));
+            printf("%-5s %4d %.4s %.4s      %-8s %-6s %-12s\n", "D", node->y_lineNr, buffer, buffer + 4, y_label, y_func, y_value);
         }
     }
     
@@ -299,7 +625,7 @@ void printSYM(SymNode* node, int depth) {
 /// Consumes tokens until a T_EOL token is encountered.
 /// Resets line error flag afterward.
 void skipToEOL() {
-    while (tokTyp != T_EOL) {
+    while (tokTyp != T_EOL && tokTyp != EOF) {
         fetchToken();
     }
     lineERR = FALSE;
@@ -310,28 +636,9 @@ void skipToEOL() {
 bool checkReservedWord() {
     strToUpper(label);
 
-    // Check Opcodes
-    int num_Opcode = (sizeof(opCodeTab) / sizeof(opCodeTab[0]));
-    for (int i = 0; i < num_Opcode; i++) {
-        if (strcmp(label, opCodeTab[i].mnemonic) == 0) {
-            return FALSE;
-        }
-    }
-
-    // Check Directives
-    int num_dircode = (sizeof(dirCodeTab) / sizeof(dirCodeTab[0]));
-    for (int i = 0; i < num_dircode; i++) {
-        if (strcmp(label, dirCodeTab[i].directive) == 0) {
-            return FALSE;
-        }
-    }
-
-    // Check Reserved Words
-    int num_resWord = (sizeof(resWordTab) / sizeof(resWordTab[0]));
-    for (int i = 0; i < num_resWord; i++) {
-        if (strcmp(label, resWordTab[i].resWord) == 0) {
-            return FALSE;
-        }
+    // Check Opcodes, Directives and Reserved Words
+    if (findOpCode(label) >= 0 || findDirective(label) >= 0 || findResWord(label) >= 0) {
+        return FALSE;
     }
     return TRUE;
 }
@@ -481,9 +788,6 @@ bool checkCtrlReg() {
 ///
 int64_t parseFactor() {
     int64_t n = 0;
-    intmax_t tmp;
-    char* endptr;
-    errno = 0;
 
     if (tokTyp == T_LPAREN) {
         fetchToken();
@@ -499,14 +803,12 @@ int64_t parseFactor() {
     }
     else {
         if (tokTyp == T_NUM) {
-            tmp = strtoimax(token, &endptr, 0);
-            n = (int64_t)tmp;
+            n = numToken;
         }
         else if (tokTyp == T_IDENTIFIER) {
             searchScopeLevel = currentScopeLevel;
             if (searchSymbol(scopeTab[searchScopeLevel], token)) {
                 if (strcmp(symFunc, "EQU") == 0) {
-                    strcpy(token, symValue);
                     varType = V_VALUE;
                 }
                 else if (strcmp(symFunc, "WORD") == 0 ||
@@ -532,7 +834,7 @@ int64_t parseFactor() {
 
             // Resolve based on type
             if (varType == V_VALUE) {
-                n = atoll(token);
+                n = symNumValue;
             }
             else if (varType == V_MEMGLOBAL) {
                 // TODO: Confirm HALF and BYTE alignment in memory
@@ -621,12 +923,17 @@ int64_t parseExpression() {
 /// @brief Advance to the next token in the token stream.
 /// 
 /// Updates the global token information (`token`, `tokTyp`, `lineNr`, `column`)
-/// from the linked token list.
+/// from the token stream. The final EOF token is never passed.
 ///
 void fetchToken() {
-    ptr_t = ptr_t->next;
-    strcpy(token, ptr_t->t_token);
+    if (hasToken(tokenIndex + 1)) {
+        tokenIndex++;
+    }
+    ptr_t = getToken(tokenIndex);
+    getTokenText(ptr_t, token);
     tokTyp = ptr_t->t_tokTyp;
+    tokId = ptr_t->t_id;
+    numToken = ptr_t->t_value;
     lineNr = ptr_t->t_lineNr;
     column = ptr_t->t_column;
 }
@@ -890,7 +1197,7 @@ void parseCBR_CBRU() {
 
     // Parse offset operand
     if (tokTyp == T_NUM) {
-        value = strToNum(token);
+        value = numToken;
         if (is_negative) value = -value;
         operandType = OT_VALUE;
         ASTop3 = createASTnode(NODE_OPERAND, ">", value);
@@ -900,6 +1207,7 @@ void parseCBR_CBRU() {
         operandType = OT_LABEL;
         ASTop3 = createASTnode(NODE_OPERAND, token, 0);
         addASTchild(ASTinstruction, ASTop3);
+        addLabelRef(ASTop3);
     }
 }
 
@@ -924,7 +1232,7 @@ void parseB() {
 
     // Parse offset
     if (tokTyp == T_NUM) {
-        value = strToNum(token);
+        value = numToken;
         if (is_negative) value = -value;
         operandType = OT_VALUE;
         ASTop1 = createASTnode(NODE_OPERAND, ">", value);
@@ -934,6 +1242,7 @@ void parseB() {
         operandType = OT_LABEL;
         ASTop1 = createASTnode(NODE_OPERAND, token, 0);
         addASTchild(ASTinstruction, ASTop1);
+        addLabelRef(ASTop1);
     }
 
     // Optional comma + register
@@ -972,7 +1281,7 @@ void parseB() {
  */
 void parseBRK() {
     if (tokTyp == T_NUM) {
-        value = strToNum(token);
+        value = numToken;
         if (is_negative) value = -value;
         operandType = OT_VALUE;
         ASTop1 = createASTnode(NODE_OPERAND, ">", value);
@@ -988,7 +1297,7 @@ void parseBRK() {
     }
     fetchToken();
     if (tokTyp == T_NUM) {
-        value = strToNum(token);
+        value = numToken;
         if (is_negative) value = -value;
         operandType = OT_VALUE;
         ASTop2 = createASTnode(NODE_OPERAND, ">", value);
@@ -2795,7 +3104,7 @@ void parseGATE() {
 
     if (tokTyp == T_NUM) {                  // operand is a number
 
-        value = strToNum(token);
+        value = numToken;
         if (is_negative == TRUE) {
 
             value = 0 - value;
@@ -2809,6 +3118,7 @@ void parseGATE() {
         operandType = OT_LABEL;
         ASTop2 = createASTnode(NODE_OPERAND, token, 0);
         addASTchild(ASTinstruction, ASTop2);
+        addLabelRef(ASTop2);
     }
 }
 
@@ -3993,15 +4303,8 @@ void parseInstruction() {
     // ----------------------------------------------------
     // Step 1: Validate opcode against table
     // ----------------------------------------------------
-    int num_Opcode = sizeof(opCodeTab) / sizeof(opCodeTab[0]);
-    bool opCode_found = FALSE;
-    for (i = 0; i < num_Opcode; i++) {
-        if (strcmp(opCode, opCodeTab[i].mnemonic) == 0) {
-            opCode_found = TRUE;
-            break;
-        }
-    }
-    if (!opCode_found) {
+    i = findOpCode(opCode);
+    if (i < 0) {
         snprintf(errmsg, sizeof(errmsg), "Invalid Opcode %s ", opCode);
         processError(errmsg);
         skipToEOL();
@@ -4025,7 +4328,7 @@ void parseInstruction() {
     if (strcmp(label, "") != 0) {
         symFound = FALSE;
         searchScopeLevel = currentScopeLevel;
-        searchSymLevel(scopeTab[searchScopeLevel], label, 0);
+        searchSymLevel(label);
 
         if (!symFound) {
             strcpy(dirCode, "LABEL");
@@ -4152,26 +4455,19 @@ void ParseDirective() {
     strToUpper(dirCode);
 
     // Lookup directive in table
-    int num_dircode = (sizeof(dirCodeTab) / sizeof(dirCodeTab[0]));
-    bool dirCode_found = FALSE;
-    for (i = 0; i < num_dircode; i++) {
-        if (strcmp(dirCode, dirCodeTab[i].directive) == 0) {
-            dirCode_found = TRUE;
-            directiveType = dirCodeTab[i].directNum;
-            break;
-        }
-    }
+    i = findDirective(dirCode);
 
     // Handle unknown directives
-    if (dirCode_found == FALSE) {
+    if (i < 0) {
         snprintf(errmsg, sizeof(errmsg), "Invalid directive %s", token);
         processError(errmsg);
         skipToEOL();
         return;
     }
+    directiveType = dirCodeTab[i].directNum;
 
     // Process recognized directive
-    if (dirCode_found == TRUE) {
+    if (i >= 0) {
         switch (directiveType) {
 
         // ---------------------------------------------------------------------
@@ -4224,7 +4520,7 @@ void ParseDirective() {
 
                     symFound = FALSE;
                     searchScopeLevel = currentScopeLevel;
-                    searchSymLevel(scopeTab[searchScopeLevel], label, 0);
+                    searchSymLevel(label);
 
                     if (!symFound) {
 
@@ -4232,6 +4528,7 @@ void ParseDirective() {
                         directive = createSYMnode(SCOPE_DIRECT, label, dirCode, "", lineNr);
                         addSYMchild(scopeTab[currentScopeLevel], directive);
                         strcpy(currentCODE, label);
+                        currentCODEId = internString(currentCODE);
                     }
                     else {
 
@@ -4412,7 +4709,7 @@ void ParseDirective() {
                 if (strcmp(label, "") != 0) {
                     symFound = FALSE;
                     searchScopeLevel = currentScopeLevel;
-                    searchSymLevel(scopeTab[searchScopeLevel], label, 0);
+                    searchSymLevel(label);
 
                     if (!symFound) {
                         strcpy(dirCode, "DATA");
@@ -4455,7 +4752,7 @@ void ParseDirective() {
         case D_ALIGN:
             /// Aligns data address to specified boundary (optionally with 'K' suffix).
             fetchToken();
-            align = atoi(token);
+            align = (int)numToken;
             fetchToken();
             strToUpper(token);
             if (strcmp(token, "K") == 0) {
@@ -4478,6 +4775,9 @@ void ParseDirective() {
             fetchToken();
             if (checkReservedWord()) {
                 addDirectiveToScope(SCOPE_DIRECT, label, dirCode, token, lineNr);
+                if (directiveType == D_EQU) {
+                    directive->y_value = numToken;   // evaluated by the lexer
+                }
             }
             else {
                 snprintf(errmsg, sizeof(errmsg), "Symbol %s is a reserved word", label);
@@ -4542,8 +4842,7 @@ void ParseDirective() {
                 dataAdr = ((dataAdr / 4) * 4) + 4;
             }
             if ((dataAdrOld - dataAdr) != 0) {
-                strcpy(elfData, "\0\0\0\0\0\0\0\0");
-                addDataSectionData(elfData, dataAdr - dataAdrOld);
+                addDataSectionFill(0, dataAdr - dataAdrOld);
             }
 
             // Write symbol table entry
@@ -4555,18 +4854,9 @@ void ParseDirective() {
             }
             addDirectiveToScope(SCOPE_DIRECT, label, dirCode, buffer, lineNr);
 
-            // Allocate memory for buffer
-            elfBuffer = (char*)malloc(buf_size);
-            elfDataLength = 0;
-
-            // Initialize buffer
-            do {
-                elfBuffer[elfDataLength] = buf_init & 0xFF;
-                elfDataLength++;
-                buf_size--;
-            } while (buf_size > 0);
-
-            addDataSectionData(elfBuffer, elfDataLength);
+            // Fill buffer (at least one byte); zero buffers take no file space
+            elfDataLength = (buf_size > 0) ? buf_size : 1;
+            addDataSectionFill(buf_init & 0xFF, elfDataLength);
             dataAdr = (dataAdr + elfDataLength);
             numOfData += elfDataLength;
             break;
@@ -4664,8 +4954,7 @@ void ParseDirective() {
                 dataAdr = ((dataAdr / 2) * 2) + 2;
             }
             if ((dataAdrOld - dataAdr) != 0) {
-                strcpy(elfData, "\0\0\0\0\0\0\0\0");
-                addDataSectionData(elfData, dataAdr - dataAdrOld);
+                addDataSectionFill(0, dataAdr - dataAdrOld);
             }
             sprintf(token, "%d", value);
             // Write in SYMTAB
@@ -4721,8 +5010,7 @@ void ParseDirective() {
                 dataAdr = ((dataAdr / 4) * 4) + 4;
             }
             if ((dataAdrOld - dataAdr) != 0) {
-                strcpy(elfData, "\0\0\0\0\0\0\0\0");
-                addDataSectionData(elfData, dataAdr - dataAdrOld);
+                addDataSectionFill(0, dataAdr - dataAdrOld);
             }
             sprintf(token, "%d", value);
             // Write in SYMTAB
@@ -4781,8 +5069,7 @@ void ParseDirective() {
                 dataAdr = ((dataAdr / 8) * 8) + 8;
             }
             if ((dataAdrOld - dataAdr) != 0) {
-                strcpy(elfData, "\0\0\0\0\0\0\0\0");
-                addDataSectionData(elfData, dataAdr - dataAdrOld);
+                addDataSectionFill(0, dataAdr - dataAdrOld);
             }
             sprintf(token, "%lld", value);
             // Write in SYMTAB
@@ -4826,8 +5113,7 @@ void ParseDirective() {
                 dataAdr = ((dataAdr / 4) * 4) + 4;
             }
             if ((dataAdr - dataAdrOld) != 0) {
-                strcpy(elfData, "\0\0\0\0\0\0\0\0");
-                addDataSectionData(elfData, dataAdr - dataAdrOld);
+                addDataSectionFill(0, dataAdr - dataAdrOld);
             }
             // Write in SYMTAB
             addDirectiveToScope(SCOPE_DIRECT, label, dirCode, token, lineNr);
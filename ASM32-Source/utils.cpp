@@ -1,13 +1,25 @@
 #include "constants.hpp"
 #include "ASM32.hpp"
 
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 /// @file
 /// \brief Provides helper and utility functions for the ASM32 assembler.
 /// \details
 /// This file implements common helper routines, such as:
-/// - File handling (open/close source files).
+/// - File handling (map/unmap source files).
 /// - Error and warning reporting.
 /// - String manipulation (uppercase conversion, numeric parsing).
+/// - Identifier interning (names to 32-bit IDs).
 /// - Debug output.
 /// - Character classification helpers.
 
@@ -16,22 +28,83 @@
 //  File Handling
 // ====================================================================================
 
-/// \brief Opens the source file for reading.
+/// \brief Maps the source file into memory for reading.
 /// \details
-/// Attempts to open the source file specified in `SourceFileName` for reading.
-/// If the file cannot be opened, an error message is printed to stderr.
+/// The whole file specified in `SourceFileName` is mapped read-only into
+/// `srcBuf` (length `srcLen`). The lexer scans the mapped bytes directly,
+/// so source lines are never copied. Where `mmap` is not available
+/// (Windows) or fails, the file is read into a heap buffer in one call.
+/// If the file cannot be opened, an error is printed and the assembly is abandoned.
 void openSourceFile() {
     printf("source %s", SourceFileName);
-    inputFile = fopen(SourceFileName, "r");
+    srcBuf = NULL;
+    srcLen = 0;
+    srcMapped = FALSE;
+
+#ifndef _WIN32
+    int fd = open(SourceFileName, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr,
+            "\n----- Input file \"%s\" could not be opened for reading -----\n\n", SourceFileName);
+        fatalError("source file not readable");
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            srcBuf = (char*)map;
+            srcLen = st.st_size;
+            srcMapped = TRUE;
+        }
+    }
+    close(fd);
+    if (srcMapped == TRUE) {
+        return;
+    }
+#endif
+
+    // Fallback: read the complete file into one heap buffer.
+    FILE* inputFile = fopen(SourceFileName, "rb");
     if (inputFile == NULL) {
         fprintf(stderr,
             "\n----- Input file \"%s\" could not be opened for reading -----\n\n", SourceFileName);
+        fatalError("source file not readable");
     }
+    size_t size = 0;
+    size_t cap = 65536;
+    srcBuf = (char*)malloc(cap);
+    if (srcBuf == NULL) {
+        fatalError("malloc failed");
+    }
+    size_t n;
+    while ((n = fread(srcBuf + size, 1, cap - size, inputFile)) > 0) {
+        size += n;
+        if (size == cap) {
+            cap *= 2;
+            srcBuf = (char*)realloc(srcBuf, cap);
+            if (srcBuf == NULL) {
+                fatalError("realloc failed");
+            }
+        }
+    }
+    fclose(inputFile);
+    srcLen = size;
 }
 
-/// \brief Closes the currently opened source file.
+/// \brief Releases the mapping (or buffer) of the source file.
 void closeSourceFile() {
-    fclose(inputFile);
+#ifndef _WIN32
+    if (srcMapped == TRUE) {
+        munmap(srcBuf, srcLen);
+        srcBuf = NULL;
+        srcLen = 0;
+        return;
+    }
+#endif
+    free(srcBuf);
+    srcBuf = NULL;
+    srcLen = 0;
 }
 
 
@@ -90,15 +163,17 @@ void extract_path(const char* fullpath, char* path_out, size_t out_size) {
 //  Error Handling
 // ====================================================================================
 
-/// \brief Prints a fatal error and terminates the program.
+/// \brief Prints a fatal error and abandons the current assembly.
 /// \param msg A null-terminated error message string.
 /// \details
 /// Displays the given message on standard output, followed by a termination
-/// notice, then exits with status code 255.
+/// notice, then throws ::assemblyAbort. assembleFile() catches it, releases
+/// the assembly and returns status code 255; other assemblies in the
+/// process carry on.
 void fatalError(const char* msg) {
     printf("Fatal Error> %s\n", msg);
     printf("\n----- ASM32 Assembler terminated -----\n");
-    exit(255);
+    throw assemblyAbort();
 }
 
 /// \brief Reports an error encountered during processing.
@@ -108,13 +183,20 @@ void fatalError(const char* msg) {
 /// - Wraps the error message into a `SRC_ERROR` node in the source tree.
 /// - Links the error node into the current SRC node hierarchy.
 /// - Sets binary status to `B_NOBIN`.
+/// - With an ::errorSink installed (parallel code generation) the message is
+///   handed to the sink instead and reported later.
 void processError(const char* msg) {
     lineERR = TRUE;
     sourceERR = TRUE;
+    if (errorSink != NULL) {
+        bin_status = B_NOBIN;
+        errorSink(msg);
+        return;
+    }
     strcpy(buffer, msg);
     strcat(buffer, "\n");
 
-    searchSRC(GlobalSRC, 0);
+    searchSRC();
 
     bin_status = B_NOBIN;
     SRCerror = createSRCnode(SRC_ERROR, buffer, lineNr);
@@ -132,7 +214,7 @@ void processWarning(const char* msg) {
     strcpy(buffer, msg);
     strcat(buffer, "\n");
 
-    searchSRC(GlobalSRC, 0);
+    searchSRC();
 
     bin_status = B_NOBIN;
     SRCerror = createSRCnode(SRC_WARNING, buffer, lineNr);
@@ -147,7 +229,7 @@ void processInfo(const char* msg) {
     strcpy(buffer, msg);
     strcat(buffer, "\n");
 
-    searchSRC(GlobalSRC, 0);
+    searchSRC();
 
     bin_status = B_NOBIN;
     SRCerror = createSRCnode(SRC_WARNING, buffer, lineNr);
@@ -177,6 +259,116 @@ void strToUpper(char* _str) {
     }
 }
 
+// ====================================================================================
+//  Arena Allocation
+// ====================================================================================
+
+#define ARENA_CHUNK_SIZE 65536          ///< Default usable size of an arena chunk.
+#define ARENA_ALIGN      16             ///< Alignment of every arena allocation.
+
+/// \brief Header of an arena chunk (the usable memory follows it).
+struct alignas(ARENA_ALIGN) arenaChunk {
+    struct arenaChunk* prev;            ///< Previously filled chunk.
+};
+
+/// \brief Allocates memory from an arena.
+/// \param a    Arena to allocate from.
+/// \param size Number of bytes.
+/// \return Pointer to uninitialized memory, aligned to ::ARENA_ALIGN.
+/// \details
+/// Requests are served from the current chunk; a new 64 KB chunk is started
+/// when it is full, requests larger than that get a chunk of their own.
+/// Fatal error if memory allocation fails.
+void* arenaAlloc(struct arena* a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (a->ar_chunk == NULL || a->ar_used + size > a->ar_size) {
+        size_t chunkSize = (size > ARENA_CHUNK_SIZE) ? size : ARENA_CHUNK_SIZE;
+        struct arenaChunk* chunk = (struct arenaChunk*)malloc(sizeof(struct arenaChunk) + chunkSize);
+        if (chunk == NULL) {
+            fatalError("malloc failed");
+        }
+        chunk->prev = a->ar_chunk;
+        a->ar_chunk = chunk;
+        a->ar_used = 0;
+        a->ar_size = chunkSize;
+    }
+    void* p = (char*)(a->ar_chunk + 1) + a->ar_used;
+    a->ar_used += size;
+    return p;
+}
+
+/// \brief Copies a null-terminated string into an arena.
+char* arenaText(struct arena* a, const char* text) {
+    size_t len = strlen(text) + 1;
+    char* p = (char*)arenaAlloc(a, len);
+    memcpy(p, text, len);
+    return p;
+}
+
+/// \brief Makes room for one more element in a child span.
+/// \param a        Arena the span lives in.
+/// \param span     Current span (NULL when empty).
+/// \param count    Number of elements in use.
+/// \param elemSize Size of one element.
+/// \return The span to store element `count` in.
+/// \details
+/// The capacity of a span is not stored: it is 4 for up to 4 elements and
+/// the next power of two above that. When a span is full its elements are
+/// copied into a span of twice the size; the old span stays in the arena
+/// until the arena is released.
+void* arenaSpan(struct arena* a, void* span, int count, size_t elemSize) {
+    if (count == 0) {
+        return arenaAlloc(a, 4 * elemSize);
+    }
+    if (count >= 4 && (count & (count - 1)) == 0) {
+        void* grown = arenaAlloc(a, 2 * (size_t)count * elemSize);
+        memcpy(grown, span, (size_t)count * elemSize);
+        return grown;
+    }
+    return span;
+}
+
+/// \brief Moves all memory of one arena into another.
+/// \details
+/// The chunks of `src` are linked in below the current chunk of `dst`, so
+/// they are released together with `dst`. `src` is empty afterwards.
+void arenaAdopt(struct arena* dst, struct arena* src) {
+    if (src->ar_chunk == NULL) {
+        return;
+    }
+    if (dst->ar_chunk == NULL) {
+        *dst = *src;
+    }
+    else {
+        struct arenaChunk* oldest = src->ar_chunk;
+        while (oldest->prev != NULL) {
+            oldest = oldest->prev;
+        }
+        oldest->prev = dst->ar_chunk->prev;
+        dst->ar_chunk->prev = src->ar_chunk;
+    }
+    src->ar_chunk = NULL;
+    src->ar_used = 0;
+    src->ar_size = 0;
+}
+
+/// \brief Gives all memory of an arena back at once.
+/// \details
+/// Every pointer handed out by the arena becomes invalid. The arena can be
+/// used again afterwards.
+void arenaRelease(struct arena* a) {
+    struct arenaChunk* chunk = a->ar_chunk;
+    while (chunk != NULL) {
+        struct arenaChunk* prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+    a->ar_chunk = NULL;
+    a->ar_used = 0;
+    a->ar_size = 0;
+}
+
+
 /// \brief Converts a string to an integer.
 /// \param _str Null-terminated string containing a number.
 /// \return Integer value parsed from the string.
@@ -189,6 +381,208 @@ int strToNum(char* _str) {
 }
 
 
+// ====================================================================================
+//  Identifier Interning
+// ====================================================================================
+
+#define INTERN_PAGE_BITS 12                           ///< log2 of the names per page.
+#define INTERN_PAGE_SIZE (1u << INTERN_PAGE_BITS)     ///< Names per page.
+#define INTERN_PAGES 4096                             ///< Maximum number of pages.
+
+/// \brief Interned names of one assembly.
+/// \details
+/// The names are kept in fixed pages that never move, so internText() can
+/// read them without the lock while another thread interns new names.
+struct interner {
+    const char** i_pages[INTERN_PAGES]; ///< Interned names by ID (ID 0 is unused).
+    std::atomic<uint32_t> i_count;      ///< Next free ID, published after the name is stored.
+    uint32_t* i_hash;                   ///< Open-addressing hash table of IDs.
+    uint32_t i_hashSize;                ///< Number of slots in i_hash (power of 2).
+    std::mutex i_lock;                  ///< Serializes insertions (lexer and parser threads).
+    struct arena i_text;                ///< Name texts.
+};
+
+/// \brief Per-thread cache of recently interned names.
+/// \details A thread only ever works for one assembly, so the cache always
+/// refers to the interner in ::internTab.
+static thread_local struct internCacheEntry {
+    uint32_t hash;                      ///< Full hash of the name.
+    uint32_t id;                        ///< ID of the name.
+    const char* name;                   ///< Interned name text.
+} internCache[256];
+
+/// \brief Create the interner of an assembly.
+/// \details The caller stores it in ::internTab and hands it to every thread
+/// working for the assembly.
+struct interner* createInterner() {
+    struct interner* t = new (std::nothrow) struct interner();
+    if (t == NULL) {
+        fatalError("malloc failed");
+    }
+    t->i_count.store(1);
+    memset(internCache, 0, sizeof(internCache));
+    return t;
+}
+
+/// \brief Free an interner and all of its names.
+void releaseInterner(struct interner* t) {
+    if (t == NULL) {
+        return;
+    }
+    for (int page = 0; page < INTERN_PAGES && t->i_pages[page] != NULL; page++) {
+        free(t->i_pages[page]);
+    }
+    free(t->i_hash);
+    arenaRelease(&t->i_text);
+    delete t;
+}
+
+/// \brief FNV-1a hash of a name.
+static uint32_t hashName(const char* text, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return h;
+}
+
+/// \brief Return the name with the given ID.
+static inline const char* nameOf(const struct interner* t, uint32_t id) {
+    return t->i_pages[id >> INTERN_PAGE_BITS][id & (INTERN_PAGE_SIZE - 1)];
+}
+
+/// \brief Look a name up in the thread-local cache.
+/// \return The cache entry of the name, or NULL if it is not cached.
+static struct internCacheEntry* cachedName(const char* text, int len, uint32_t hash) {
+    struct internCacheEntry* e = &internCache[hash & 255];
+    if (e->name != NULL && e->hash == hash && strncmp(e->name, text, len) == 0 && e->name[len] == '\0') {
+        return e;
+    }
+    return NULL;
+}
+
+/// \brief Remember a name in the thread-local cache.
+static void cacheName(uint32_t hash, uint32_t id) {
+    struct internCacheEntry* e = &internCache[hash & 255];
+    e->hash = hash;
+    e->id = id;
+    e->name = nameOf(internTab, id);
+}
+
+/// \brief Return the hash slot of a name (either its ID or an empty slot).
+static uint32_t* findSlot(struct interner* t, const char* text, int len, uint32_t hash) {
+    uint32_t mask = t->i_hashSize - 1;
+    uint32_t i = hash & mask;
+    while (t->i_hash[i] != 0) {
+        const char* name = nameOf(t, t->i_hash[i]);
+        if (strncmp(name, text, len) == 0 && name[len] == '\0') {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &t->i_hash[i];
+}
+
+/// \brief Double the hash table and re-insert all interned names.
+static void growInternHash(struct interner* t) {
+    free(t->i_hash);
+    t->i_hashSize = (t->i_hashSize == 0) ? 1024 : t->i_hashSize * 2;
+    t->i_hash = (uint32_t*)calloc(t->i_hashSize, sizeof(uint32_t));
+    if (t->i_hash == NULL) {
+        fatalError("malloc failed");
+    }
+    uint32_t count = t->i_count.load(std::memory_order_relaxed);
+    for (uint32_t id = 1; id < count; id++) {
+        const char* name = nameOf(t, id);
+        int len = (int)strlen(name);
+        *findSlot(t, name, len, hashName(name, len)) = id;
+    }
+}
+
+/// \brief Intern a name and return its ID.
+/// \param text Name (need not be terminated).
+/// \param len  Length of the name.
+/// \return ID of the name (never 0).
+/// \details
+/// Equal names always get the same ID within an assembly, so names can be
+/// compared as integers. The names live in the interner of the assembly
+/// (::internTab) until releaseInterner().
+/// Safe to call from several threads: names seen recently by the calling
+/// thread are answered from a thread-local cache, insertions are locked.
+/// Names never move once interned, so internText() needs no lock.
+uint32_t internName(const char* text, int len) {
+    uint32_t hash = hashName(text, len);
+    struct internCacheEntry* e = cachedName(text, len, hash);
+    if (e != NULL) {
+        return e->id;
+    }
+
+    struct interner* t = internTab;
+    std::lock_guard<std::mutex> guard(t->i_lock);
+    uint32_t count = t->i_count.load(std::memory_order_relaxed);
+    if ((count + 1) * 2 > t->i_hashSize) {
+        growInternHash(t);
+    }
+    uint32_t* slot = findSlot(t, text, len, hash);
+    if (*slot == 0) {
+        uint32_t page = count >> INTERN_PAGE_BITS;
+        if (page >= INTERN_PAGES) {
+            fatalError("too many names");
+        }
+        if (t->i_pages[page] == NULL) {
+            t->i_pages[page] = (const char**)malloc(INTERN_PAGE_SIZE * sizeof(const char*));
+            if (t->i_pages[page] == NULL) {
+                fatalError("malloc failed");
+            }
+        }
+        char* name = (char*)arenaAlloc(&t->i_text, len + 1);
+        memcpy(name, text, len);
+        name[len] = '\0';
+        t->i_pages[page][count & (INTERN_PAGE_SIZE - 1)] = name;
+        *slot = count;
+        t->i_count.store(count + 1, std::memory_order_release);
+    }
+    cacheName(hash, *slot);
+    return *slot;
+}
+
+/// \brief Intern a null-terminated name and return its ID.
+uint32_t internString(const char* text) {
+    return internName(text, (int)strlen(text));
+}
+
+/// \brief Look up the ID of a name without interning it.
+/// \return ID of the name, or 0 if the name was never interned.
+/// \details Names in the thread-local cache are answered without the lock.
+uint32_t findName(const char* text) {
+    int len = (int)strlen(text);
+    uint32_t hash = hashName(text, len);
+    struct internCacheEntry* e = cachedName(text, len, hash);
+    if (e != NULL) {
+        return e->id;
+    }
+
+    struct interner* t = internTab;
+    std::lock_guard<std::mutex> guard(t->i_lock);
+    if (t->i_hashSize == 0) {
+        return 0;
+    }
+    uint32_t id = *findSlot(t, text, len, hash);
+    if (id != 0) {
+        cacheName(hash, id);
+    }
+    return id;
+}
+
+/// \brief Return the text of an interned name.
+const char* internText(uint32_t id) {
+    if (id == 0 || id >= internTab->i_count.load(std::memory_order_acquire)) {
+        return "";
+    }
+    return nameOf(internTab, id);
+}
+
+
 // ====================================================================================
 //  Character Classification
 // ====================================================================================
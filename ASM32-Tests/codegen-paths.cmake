@@ -0,0 +1,40 @@
+# Assembles one source file with code generation on the assembling thread
+# (-j 1) and on a pool of threads (-j 4) and fails unless the listing, the
+# diagnostics, the exit status and the ELF file are identical.
+#
+# Usage: cmake -DASM32=<assembler> -DSOURCE=<file.s> -DWORK=<dir> -P codegen-paths.cmake
+
+cmake_minimum_required(VERSION 3.20)
+
+get_filename_component(name "${SOURCE}" NAME_WE)
+
+foreach(threads 1 4)
+    set(dir "${WORK}/${name}-j${threads}")
+    file(REMOVE_RECURSE "${dir}")
+    file(MAKE_DIRECTORY "${dir}")
+    configure_file("${SOURCE}" "${dir}/${name}.s" COPYONLY)
+    execute_process(
+        COMMAND "${ASM32}" -j ${threads} ${name}.s
+        WORKING_DIRECTORY "${dir}"
+        OUTPUT_VARIABLE listing${threads}
+        ERROR_VARIABLE listing${threads}
+        RESULT_VARIABLE status${threads})
+endforeach()
+
+if(NOT status1 STREQUAL status4)
+    message(FATAL_ERROR "exit status differs: ${status1} (-j 1), ${status4} (-j 4)")
+endif()
+if(NOT listing1 STREQUAL listing4)
+    message(FATAL_ERROR "listing or diagnostics differ between -j 1 and -j 4")
+endif()
+
+set(elf1 "${WORK}/${name}-j1/${name}.out")
+set(elf4 "${WORK}/${name}-j4/${name}.out")
+if(EXISTS "${elf1}" OR EXISTS "${elf4}")
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E compare_files "${elf1}" "${elf4}"
+        RESULT_VARIABLE differ)
+    if(differ)
+        message(FATAL_ERROR "ELF file differs between -j 1 and -j 4")
+    endif()
+endif()
@@ -0,0 +1,44 @@
+; ======================================
+; Code generation: serial and pooled
+; ======================================
+; Several code sections with branches between them, ADDIL expansions
+; and encoding errors; the listing and the ELF file must not depend on
+; the number of code generation threads.
+; ======================================
+
+                    .GLOBAL
+
+DATA1:              .DATA addr=0x0001_0000,align=0x0000_0010,base=R8
+BUFF:               .BUFFER size=5000,init=0x11
+W1:                 .WORD 0x0123_4567
+W2:                 .WORD 0x89AB_CDEF
+
+SUB1:               .CODE addr=0x0000_1000,align=0x0000_1000
+SUB_START:          B       MAIN_LOOP
+                    ADD     R5,W1
+                    ADD.L   R1,R2,R3
+                    CMP.LT  R1,R2,R3
+                    BE      40000(R1,R2)
+                    LDIL    R1,L%16384
+                    B       SUB_END
+SUB_END:            ADD     R6,W2
+
+SUB2:               .CODE addr=0x0000_2000,align=0x0000_1000
+SUB2_START:         CBR.EQ  R2,R3,SUB2_START
+                    AND.NC  R1,R2,R3
+                    BE      6(R1,R2)
+                    EXTR    R1,R2,4,8
+                    DEP     R1,R2,4,8
+                    CMR.GE  R1,R2,R3
+                    ADD     R7,W1
+                    B       SUB_START
+
+MAIN:               .CODE addr=0x0000_0000,entry
+MAIN_LOOP:          ADD     R5,W1
+                    ADDB    R6,16(R13)
+                    SUB.O   R1,R2,R3
+                    CMP     R1,R2,R3
+                    CBR.NE  R1,R2,MAIN_LOOP
+                    BE      8(R1,R2)
+                    B       SUB2_START
+                    .END